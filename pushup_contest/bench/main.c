@@ -0,0 +1,146 @@
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "detector.h"
+#include "saul_trace.h"
+#include "ztimer.h"
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS    (100U)
+#endif
+
+/* a detection counts for a ground truth repetition within this distance */
+#define MATCH_WINDOW_MS     (1000)
+
+#define MAX_DETECTIONS      (256U)
+
+static detector_window_t _window;
+static detector_iir_t _iir;
+
+static uint32_t _detections[MAX_DETECTIONS];
+
+static inline uint64_t _cycles(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    return __builtin_ia32_rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void _to_accel_sample(const saul_trace_sample_t *in, accel_sample_t *out)
+{
+    out->time = in->time_ms * 1000U;
+    out->acc[0] = in->acc[0];
+    out->acc[1] = in->acc[1];
+    out->acc[2] = in->acc[2];
+}
+
+static unsigned _detect(detector_t *det)
+{
+    size_t len = saul_trace_len();
+    unsigned cnt = 0;
+    accel_sample_t sample;
+
+    detector_reset(det);
+    for (size_t i = 0; i < len; i++) {
+        _to_accel_sample(saul_trace_get(i), &sample);
+        if ((detector_process(det, &sample) == DETECTOR_EVENT_REP)
+            && (cnt < MAX_DETECTIONS)) {
+            _detections[cnt++] = saul_trace_get(i)->time_ms;
+        }
+    }
+
+    return cnt;
+}
+
+static void _run(const char *name, detector_t *det)
+{
+    size_t len = saul_trace_len();
+    unsigned detected = _detect(det);
+    unsigned reps = 0;
+    unsigned matched = 0;
+    int32_t latency_sum = 0;
+    int32_t latency_max = INT32_MIN;
+    unsigned next = 0;
+
+    /* match ground truth and detections in order of time */
+    for (size_t i = 0; i < len; i++) {
+        const saul_trace_sample_t *s = saul_trace_get(i);
+        if (!(s->flags & SAUL_TRACE_FLAG_REP)) {
+            continue;
+        }
+        reps++;
+
+        while ((next < detected)
+               && ((int32_t)(_detections[next] - s->time_ms) < -MATCH_WINDOW_MS)) {
+            next++;
+        }
+        if ((next < detected)
+            && ((int32_t)(_detections[next] - s->time_ms) <= MATCH_WINDOW_MS)) {
+            int32_t latency = _detections[next] - s->time_ms;
+            latency_sum += latency;
+            if (latency > latency_max) {
+                latency_max = latency;
+            }
+            matched++;
+            next++;
+        }
+    }
+
+    /* the actual cost, measured over several passes */
+    accel_sample_t sample;
+    uint32_t start = ztimer_now(ZTIMER_USEC);
+    uint64_t cycles = _cycles();
+
+    for (unsigned it = 0; it < BENCH_ITERATIONS; it++) {
+        detector_reset(det);
+        for (size_t i = 0; i < len; i++) {
+            _to_accel_sample(saul_trace_get(i), &sample);
+            detector_process(det, &sample);
+        }
+    }
+
+    cycles = _cycles() - cycles;
+    uint32_t duration = ztimer_now(ZTIMER_USEC) - start;
+    uint32_t processed = BENCH_ITERATIONS * len;
+    unsigned false_pos = detected - matched;
+
+    printf("%-8s %5u %8u %6u %6u %5u%% %8" PRId32 " %8" PRId32 " %10" PRIu32
+           " %9" PRIu32 "\n",
+           name, reps, detected, reps - matched, false_pos,
+           (reps + false_pos) ? (100 * matched) / (reps + false_pos) : 100,
+           matched ? latency_sum / (int32_t)matched : 0,
+           matched ? latency_max : 0,
+           (uint32_t)(cycles / processed),
+           (uint32_t)(((uint64_t)duration * 1000) / processed));
+}
+
+int main(void)
+{
+    if (saul_trace_init() <= 0) {
+        return 1;
+    }
+
+    size_t len = saul_trace_len();
+    uint32_t span = saul_trace_get(len - 1)->time_ms - saul_trace_get(0)->time_ms;
+    unsigned rate_hz = span ? ((len - 1) * 1000U + span / 2) / span : 1;
+
+    printf("trace: %s\n", CONFIG_SAUL_TRACE_FILE);
+    printf("%u samples, %" PRIu32 " ms, %u Hz, %u iterations\n\n",
+           (unsigned)len, span, rate_hz, BENCH_ITERATIONS);
+
+    /* latency is relative to the end of the repetition in the trace, the
+     * accuracy counts false positives and misses against the hits */
+    puts("engine    reps detected missed falsep  acc lat_avg  lat_max "
+         "cyc/sample ns/sample");
+
+    detector_window_init(&_window, rate_hz);
+    _run("window", &_window.super);
+
+    detector_iir_init(&_iir, rate_hz);
+    _run("iir", &_iir.super);
+
+    return 0;
+}
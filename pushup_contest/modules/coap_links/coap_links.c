@@ -0,0 +1,129 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "net/gcoap.h"
+
+#include "coap_links.h"
+
+#define ENABLE_DEBUG 0
+#include "debug.h"
+
+/* all initialized tables, searched by the encoder */
+static coap_links_t *_links;
+
+void coap_links_sort(coap_resource_t *resources, size_t len)
+{
+    /* tables are short and built once, insertion sort does */
+    for (size_t i = 1; i < len; i++) {
+        coap_resource_t tmp = resources[i];
+        size_t j = i;
+
+        while ((j > 0) && (strcmp(resources[j - 1].path, tmp.path) > 0)) {
+            resources[j] = resources[j - 1];
+            j--;
+        }
+        resources[j] = tmp;
+    }
+}
+
+static int _append(coap_links_t *links, size_t *pos, const char *str)
+{
+    size_t len = strlen(str);
+
+    if (len > sizeof(links->buf) - *pos) {
+        return -ENOBUFS;
+    }
+    memcpy(&links->buf[*pos], str, len);
+    *pos += len;
+
+    return 0;
+}
+
+int coap_links_init(coap_links_t *links, const coap_resource_t *resources,
+                    size_t len, const char *const *params)
+{
+    size_t pos = 0;
+
+    if (len > CONFIG_COAP_LINKS_MAX) {
+        return -ENOBUFS;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        if ((i > 0) && (strcmp(resources[i - 1].path, resources[i].path) >= 0)) {
+            printf("coap_links: %s must sort before %s\n",
+                   resources[i].path, resources[i - 1].path);
+            assert(0);
+            return -EINVAL;
+        }
+
+        if (i > 0) {
+            _append(links, &pos, ",");
+        }
+        links->start[i] = pos;
+        if ((_append(links, &pos, "<") < 0)
+            || (_append(links, &pos, resources[i].path) < 0)
+            || (_append(links, &pos, ">") < 0)
+            || (params && params[i] && (_append(links, &pos, params[i]) < 0))) {
+            printf("coap_links: link format exceeds %u bytes\n",
+                   (unsigned)CONFIG_COAP_LINKS_BUF_SIZE);
+            return -ENOBUFS;
+        }
+    }
+    /* as if followed by another link, so link i ends at start[i + 1] - 1 */
+    links->start[len] = pos + 1;
+
+    DEBUG("coap_links: %u resources, %u bytes\n", (unsigned)len, (unsigned)pos);
+
+    links->listener = (gcoap_listener_t) {
+        resources,
+        len,
+        GCOAP_SOCKET_TYPE_UNDEF,
+        coap_links_encode,
+        NULL,
+        NULL
+    };
+
+    if (pos > COAP_LINKS_PDU_ROOM) {
+        printf("coap_links: link format of %u bytes exceeds a PDU, some links "
+               "will not be discovered\n", (unsigned)pos);
+    }
+
+    links->next = _links;
+    _links = links;
+
+    return 0;
+}
+
+ssize_t coap_links_encode(const coap_resource_t *resource, char *buf,
+                          size_t maxlen, coap_link_encoder_ctx_t *context)
+{
+    coap_links_t *links = _links;
+
+    while (links && ((resource < links->listener.resources)
+                     || (resource >= links->listener.resources
+                         + links->listener.resources_len))) {
+        links = links->next;
+    }
+    if (links == NULL) {
+        return gcoap_encode_link(resource, buf, maxlen, context);
+    }
+
+    size_t idx = resource - links->listener.resources;
+    size_t len = links->start[idx + 1] - 1 - links->start[idx];
+    size_t sep = (context->flags & COAP_LINK_FLAG_INIT_RESLIST) ? 0 : 1;
+
+    if (buf) {
+        if (sep + len > maxlen) {
+            return -1;
+        }
+        if (sep) {
+            buf[0] = ',';
+        }
+        memcpy(&buf[sep], &links->buf[links->start[idx]], len);
+    }
+
+    return sep + len;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file
+ * @brief       CoAP resource table with a precomputed link format
+ *
+ * gcoap looks up resources by walking the table of a listener and stops at
+ * the first path sorting after the requested one, so the table must be in
+ * ASCII order. coap_links_init() checks that once at startup and encodes the
+ * link format of all resources, including their link parameters, into a
+ * cache. Discovery requests on /.well-known/core and registrations with the
+ * RD then only copy from the cache instead of encoding every resource again.
+ */
+
+#ifndef COAP_LINKS_H
+#define COAP_LINKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net/gcoap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Maximum number of resources of one table
+ */
+#ifndef CONFIG_COAP_LINKS_MAX
+#define CONFIG_COAP_LINKS_MAX           (16U)
+#endif
+
+/**
+ * @brief   Size of the cached link format of one table
+ */
+#ifndef CONFIG_COAP_LINKS_BUF_SIZE
+#define CONFIG_COAP_LINKS_BUF_SIZE      (768U)
+#endif
+
+/**
+ * @brief   Room for the link format in a response to /.well-known/core
+ *
+ * What a PDU leaves after the header, a token of up to 8 bytes, the
+ * Content-Format option and the payload marker. Links beyond it are left out
+ * of discovery responses and of what an RD fetches.
+ */
+#define COAP_LINKS_PDU_ROOM             (CONFIG_GCOAP_PDU_BUF_SIZE - 16U)
+
+/**
+ * @brief   Resource table with its cached link format
+ */
+typedef struct coap_links {
+    gcoap_listener_t listener;                      /**< register this with gcoap */
+    struct coap_links *next;                        /**< next initialized table */
+    uint16_t start[CONFIG_COAP_LINKS_MAX + 1];      /**< offset of each link in buf */
+    char buf[CONFIG_COAP_LINKS_BUF_SIZE];           /**< links, separated by ',' */
+} coap_links_t;
+
+/**
+ * @brief   Sorts a table built at runtime by path
+ *
+ * Link parameters depending on the position must be set up afterwards.
+ */
+void coap_links_sort(coap_resource_t *resources, size_t len);
+
+/**
+ * @brief   Checks the order of a table and encodes its link format
+ *
+ * Sets up @p links->listener with coap_links_encode() as link encoder.
+ * @p resources and @p params must stay valid for as long as the listener is
+ * registered, @p params is indexed like @p resources and may be NULL, just
+ * like each of its entries.
+ *
+ * @return  0 on success
+ * @return  -EINVAL if the paths are not in ASCII order or not unique
+ * @return  -ENOBUFS if the table does not fit into the cache
+ */
+int coap_links_init(coap_links_t *links, const coap_resource_t *resources,
+                    size_t len, const char *const *params);
+
+/**
+ * @brief   Length of the cached link format of all resources of a table
+ */
+static inline size_t coap_links_len(const coap_links_t *links)
+{
+    return links->start[links->listener.resources_len] - 1;
+}
+
+/**
+ * @brief   Link encoder copying from the cache, see gcoap_link_encoder_t
+ */
+ssize_t coap_links_encode(const coap_resource_t *resource, char *buf,
+                          size_t maxlen, coap_link_encoder_ctx_t *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COAP_LINKS_H */
@@ -0,0 +1,175 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "detector.h"
+
+/* fractional bits of the filter states */
+#define Q                   (8)
+#define Q_ONE               (1 << Q)
+
+/* fractional bits of the gravity unit vector */
+#define AXIS_Q              (14)
+
+#define MIN_REP_US          (CONFIG_DETECTOR_IIR_MIN_REP_MS * 1000UL)
+
+static uint32_t _isqrt(uint64_t val)
+{
+    uint64_t res = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > val) {
+        bit >>= 2;
+    }
+
+    while (bit) {
+        if (val >= res + bit) {
+            val -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)res;
+}
+
+static void _reset(detector_t *det)
+{
+    detector_iir_t *iir = (detector_iir_t *)det;
+
+    iir->calib_cnt = 0;
+    for (unsigned i = 0; i < 3; i++) {
+        iir->calib_sum[i] = 0;
+        iir->calib_sq_sum[i] = 0;
+        iir->axis[i] = 0;
+    }
+    iir->axis[2] = 1 << AXIS_Q;
+    iir->lp = 0;
+    iir->gravity = 0;
+    iir->threshold = CONFIG_DETECTOR_IIR_MIN_THRESHOLD * Q_ONE;
+    iir->down = false;
+}
+
+/* component of the sample along gravity */
+static int32_t _project(const detector_iir_t *iir, const accel_sample_t *sample)
+{
+    int32_t dot = (int32_t)sample->acc[0] * iir->axis[0]
+                  + (int32_t)sample->acc[1] * iir->axis[1]
+                  + (int32_t)sample->acc[2] * iir->axis[2];
+
+    return dot >> AXIS_Q;
+}
+
+/* derives the gravity vector and thresholds from the idle window after start */
+static void _calibrate(detector_iir_t *iir)
+{
+    int64_t n = iir->calib_cnt;
+    int32_t mean[3];
+    uint64_t var = 0;
+    uint64_t len_sq = 0;
+
+    for (unsigned i = 0; i < 3; i++) {
+        mean[i] = iir->calib_sum[i] / (int32_t)n;
+        len_sq += (uint64_t)((int64_t)mean[i] * mean[i]);
+
+        /* n * sum(x^2) - sum(x)^2 is exact, subtracting squared means is not */
+        int64_t spread = n * (int64_t)iir->calib_sq_sum[i]
+                         - (int64_t)iir->calib_sum[i] * iir->calib_sum[i];
+        if (spread > 0) {
+            var += (uint64_t)spread / (uint64_t)(n * n);
+        }
+    }
+
+    /* the noise of the projection is bounded by the noise of all axes */
+    int32_t noise = (int32_t)_isqrt(var);
+    int32_t threshold = CONFIG_DETECTOR_IIR_NOISE_FACTOR * noise;
+    int32_t len = (int32_t)_isqrt(len_sq);
+
+    if (threshold < CONFIG_DETECTOR_IIR_MIN_THRESHOLD) {
+        threshold = CONFIG_DETECTOR_IIR_MIN_THRESHOLD;
+    }
+
+    /* keep the default z axis if the board was in free fall */
+    if (len > 0) {
+        for (unsigned i = 0; i < 3; i++) {
+            iir->axis[i] = (int16_t)((mean[i] * (1 << AXIS_Q)) / len);
+        }
+    }
+
+    iir->gravity = len * Q_ONE;
+    iir->lp = iir->gravity;
+    iir->threshold = threshold * Q_ONE;
+}
+
+static detector_event_t _process(detector_t *det, const accel_sample_t *sample)
+{
+    detector_iir_t *iir = (detector_iir_t *)det;
+
+    if (iir->calib_cnt < iir->calib_samples) {
+        for (unsigned i = 0; i < 3; i++) {
+            int32_t x = sample->acc[i];
+            iir->calib_sum[i] += x;
+            iir->calib_sq_sum[i] += (uint64_t)((int64_t)x * x);
+        }
+        if (++iir->calib_cnt == iir->calib_samples) {
+            _calibrate(iir);
+            return DETECTOR_EVENT_CALIBRATED;
+        }
+        return DETECTOR_EVENT_NONE;
+    }
+
+    int32_t x = _project(iir, sample);
+
+    /* low-pass against sensor noise */
+    iir->lp += (x * Q_ONE - iir->lp) >> CONFIG_DETECTOR_IIR_LP_SHIFT;
+
+    /* remove gravity, the estimate only follows the signal while it is
+     * inside the idle band so holding a position does not shift it */
+    int32_t sig = iir->lp - iir->gravity;
+
+    if ((sig < iir->threshold) && (sig > -iir->threshold)) {
+        iir->gravity += sig >> CONFIG_DETECTOR_IIR_GRAVITY_SHIFT;
+    }
+
+    if (!iir->down) {
+        if (sig < -iir->threshold) {
+            iir->down = true;
+            iir->down_time = sample->time;
+            iir->min = sig;
+            iir->min_time = sample->time;
+            return DETECTOR_EVENT_DOWN;
+        }
+    }
+    else if ((sig > iir->threshold)
+             && ((uint32_t)(sample->time - iir->down_time) >= MIN_REP_US)) {
+        iir->down = false;
+        iir->super.rep.start = iir->down_time;
+        iir->super.rep.bottom = iir->min_time;
+        iir->super.rep.end = sample->time;
+        iir->super.rep.depth = (uint16_t)((-iir->min) >> Q);
+        return DETECTOR_EVENT_REP;
+    }
+    else if (sig < iir->min) {
+        iir->min = sig;
+        iir->min_time = sample->time;
+    }
+
+    return DETECTOR_EVENT_NONE;
+}
+
+static const detector_ops_t _iir_ops = {
+    .reset = _reset,
+    .process = _process,
+};
+
+void detector_iir_init(detector_iir_t *det, unsigned rate_hz)
+{
+    unsigned calib = (rate_hz * CONFIG_DETECTOR_IIR_CALIB_MS) / 1000U;
+
+    det->super.ops = &_iir_ops;
+    det->calib_samples = (calib > 0) ? calib : 1;
+
+    _reset(&det->super);
+}
@@ -0,0 +1,89 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "detector.h"
+
+/* the original detection summed up 4 samples at 5Hz with a threshold of 250,
+ * window and threshold are scaled to keep that behaviour at other rates */
+#define WINDOW_MS               (800U)
+#define WINDOW_THRESHOLD        (250)
+#define WINDOW_SAMPLES          (4)
+
+static void _reset(detector_t *det)
+{
+    detector_window_t *win = (detector_window_t *)det;
+
+    win->started = false;
+    win->down = false;
+    win->sum = 0;
+    win->cnt = 0;
+}
+
+static detector_event_t _process(detector_t *det, const accel_sample_t *sample)
+{
+    detector_window_t *win = (detector_window_t *)det;
+    detector_event_t event = DETECTOR_EVENT_NONE;
+
+    /* the first sample is the reference for the resting position */
+    if (!win->started) {
+        win->start_value = sample->acc[2];
+        win->started = true;
+        return DETECTOR_EVENT_CALIBRATED;
+    }
+
+    int16_t dev = sample->acc[2] - win->start_value;
+
+    win->sum += dev;
+    win->cnt++;
+
+    if (win->down && (dev < win->min)) {
+        win->min = dev;
+        win->super.rep.bottom = sample->time;
+    }
+
+    if (win->sum < -win->threshold) {
+        win->sum = 0;
+        if (!win->down) {
+            win->down = true;
+            win->min = dev;
+            win->super.rep.start = sample->time;
+            win->super.rep.bottom = sample->time;
+        }
+        event = DETECTOR_EVENT_DOWN;
+    }
+    else if (win->sum > win->threshold) {
+        win->sum = 0;
+        event = DETECTOR_EVENT_UP;
+        if (win->down) {
+            win->down = false;
+            win->cnt = 0;
+            win->super.rep.end = sample->time;
+            win->super.rep.depth = (win->min < 0) ? (uint16_t)-win->min : 0;
+            event = DETECTOR_EVENT_REP;
+        }
+    }
+
+    if (win->cnt >= win->window) {
+        win->cnt = 0;
+        win->sum = 0;
+    }
+
+    return event;
+}
+
+static const detector_ops_t _window_ops = {
+    .reset = _reset,
+    .process = _process,
+};
+
+void detector_window_init(detector_window_t *det, unsigned rate_hz)
+{
+    det->super.ops = &_window_ops;
+    det->window = (int)((rate_hz * WINDOW_MS) / 1000U);
+    if (det->window < 1) {
+        det->window = 1;
+    }
+    det->threshold = (WINDOW_THRESHOLD * det->window) / WINDOW_SAMPLES;
+
+    _reset(&det->super);
+}
@@ -0,0 +1,27 @@
+/**
+ * @file
+ * @brief       Accelerometer sample as passed from the sampler to the detector
+ */
+
+#ifndef ACCEL_SAMPLE_H
+#define ACCEL_SAMPLE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   One accelerometer reading
+ */
+typedef struct {
+    uint32_t time;                  /**< sampling time in us (ZTIMER_USEC) */
+    int16_t acc[3];                 /**< x, y, z as reported by the sensor */
+} accel_sample_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ACCEL_SAMPLE_H */
@@ -0,0 +1,211 @@
+/**
+ * @file
+ * @brief       Pluggable pushup detection engines
+ *
+ * A detection engine consumes one accelerometer sample at a time and reports
+ * when the player went down, came back up and completed a repetition. All
+ * engines use integer arithmetic only and run in constant time per sample.
+ */
+
+#ifndef DETECTOR_H
+#define DETECTOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "accel_sample.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @name    Configuration of the IIR detection engine
+ * @{
+ */
+/**
+ * @brief   Low-pass filter coefficient as power of two, alpha = 1 / 2^shift
+ */
+#ifndef CONFIG_DETECTOR_IIR_LP_SHIFT
+#define CONFIG_DETECTOR_IIR_LP_SHIFT        (2U)
+#endif
+
+/**
+ * @brief   Coefficient of the gravity tracking filter as power of two
+ *
+ * The gravity estimate is a very slow low-pass, subtracting it from the
+ * signal acts as high-pass.
+ */
+#ifndef CONFIG_DETECTOR_IIR_GRAVITY_SHIFT
+#define CONFIG_DETECTOR_IIR_GRAVITY_SHIFT   (8U)
+#endif
+
+/**
+ * @brief   Length of the idle window used for calibration after start in ms
+ */
+#ifndef CONFIG_DETECTOR_IIR_CALIB_MS
+#define CONFIG_DETECTOR_IIR_CALIB_MS        (1000U)
+#endif
+
+/**
+ * @brief   Threshold in multiples of the noise measured while calibrating
+ */
+#ifndef CONFIG_DETECTOR_IIR_NOISE_FACTOR
+#define CONFIG_DETECTOR_IIR_NOISE_FACTOR    (6)
+#endif
+
+/**
+ * @brief   Lower bound for the up/down thresholds in sensor units (mg)
+ */
+#ifndef CONFIG_DETECTOR_IIR_MIN_THRESHOLD
+#define CONFIG_DETECTOR_IIR_MIN_THRESHOLD   (40)
+#endif
+
+/**
+ * @brief   Minimum time between down and up of a repetition in ms
+ */
+#ifndef CONFIG_DETECTOR_IIR_MIN_REP_MS
+#define CONFIG_DETECTOR_IIR_MIN_REP_MS      (250U)
+#endif
+/** @} */
+
+/**
+ * @brief   Events reported by a detection engine
+ */
+typedef enum {
+    DETECTOR_EVENT_NONE,            /**< nothing happened */
+    DETECTOR_EVENT_CALIBRATED,      /**< calibration finished, counting starts */
+    DETECTOR_EVENT_DOWN,            /**< player went down */
+    DETECTOR_EVENT_UP,              /**< player came up without going down */
+    DETECTOR_EVENT_REP,             /**< player came up, repetition complete */
+} detector_event_t;
+
+/**
+ * @brief   Timing and depth of a completed repetition
+ */
+typedef struct {
+    uint32_t start;                 /**< time the player went down in us */
+    uint32_t bottom;                /**< time of the lowest point in us */
+    uint32_t end;                   /**< time the player was up again in us */
+    uint16_t depth;                 /**< deepest deviation from the resting
+                                         acceleration in mg, an estimate of
+                                         the range of motion */
+} detector_rep_t;
+
+/**
+ * @brief   Forward declaration of the engine operations
+ */
+typedef struct detector_ops detector_ops_t;
+
+/**
+ * @brief   Common part of all detection engines, must be the first member
+ */
+typedef struct {
+    const detector_ops_t *ops;      /**< engine implementation */
+    detector_rep_t rep;             /**< last repetition, updated by the engine
+                                         before it reports DETECTOR_EVENT_REP */
+} detector_t;
+
+/**
+ * @brief   Interface every detection engine implements
+ */
+struct detector_ops {
+    /**
+     * @brief   Forgets all state, the next sample starts a new game
+     */
+    void (*reset)(detector_t *det);
+
+    /**
+     * @brief   Feeds the next sample into the engine
+     */
+    detector_event_t (*process)(detector_t *det, const accel_sample_t *sample);
+};
+
+/**
+ * @brief   Legacy engine: sums up the z deviation from the first sample over a
+ *          fixed window and compares it against a fixed threshold
+ */
+typedef struct {
+    detector_t super;               /**< detector base */
+    int window;                     /**< window length in samples */
+    int threshold;                  /**< up/down threshold of the window sum */
+    bool started;                   /**< start_value is valid */
+    bool down;                      /**< down detected, waiting for up */
+    int16_t start_value;            /**< z of the resting position */
+    int16_t min;                    /**< lowest z deviation while down */
+    int sum;                        /**< sum of the current window */
+    int cnt;                        /**< samples in the current window */
+} detector_window_t;
+
+/**
+ * @brief   Fixed-point IIR engine with gravity removal and thresholds
+ *          calibrated during an idle window
+ *
+ * The gravity vector is estimated from all three axes during calibration.
+ * Every sample is then projected onto it, so the detection does not depend
+ * on how the board is mounted. All filter states are kept in Q8 fixed-point.
+ */
+typedef struct {
+    detector_t super;               /**< detector base */
+    uint16_t calib_samples;         /**< length of the calibration window */
+    uint16_t calib_cnt;             /**< samples seen while calibrating */
+    int32_t calib_sum[3];           /**< per axis sum of the samples */
+    uint64_t calib_sq_sum[3];       /**< per axis sum of squares */
+    int16_t axis[3];                /**< unit vector along gravity, Q14 */
+    int32_t lp;                     /**< low-pass filtered projection, Q8 */
+    int32_t gravity;                /**< gravity estimate, Q8 */
+    int32_t threshold;              /**< up/down threshold, Q8 */
+    bool down;                      /**< down detected, waiting for up */
+    uint32_t down_time;             /**< time of the down event in us */
+    int32_t min;                    /**< lowest signal while down, Q8 */
+    uint32_t min_time;              /**< time of the lowest signal in us */
+} detector_iir_t;
+
+/**
+ * @brief   Sets up the legacy window engine
+ *
+ * @param[out] det      engine to initialize
+ * @param[in]  rate_hz  sampling rate the samples are delivered with
+ */
+void detector_window_init(detector_window_t *det, unsigned rate_hz);
+
+/**
+ * @brief   Sets up the fixed-point IIR engine
+ *
+ * @param[out] det      engine to initialize
+ * @param[in]  rate_hz  sampling rate the samples are delivered with
+ */
+void detector_iir_init(detector_iir_t *det, unsigned rate_hz);
+
+/**
+ * @brief   The repetition last reported with DETECTOR_EVENT_REP
+ */
+static inline const detector_rep_t *detector_last_rep(const detector_t *det)
+{
+    return &det->rep;
+}
+
+/**
+ * @brief   Forgets all state, the next sample starts a new game
+ */
+static inline void detector_reset(detector_t *det)
+{
+    det->ops->reset(det);
+}
+
+/**
+ * @brief   Feeds the next sample into the engine
+ *
+ * @return  what the sample revealed about the player's movement
+ */
+static inline detector_event_t detector_process(detector_t *det,
+                                                const accel_sample_t *sample)
+{
+    return det->ops->process(det, sample);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DETECTOR_H */
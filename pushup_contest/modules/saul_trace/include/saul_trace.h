@@ -0,0 +1,101 @@
+/**
+ * @file
+ * @brief       Simulated SAUL accelerometer replaying a recorded trace
+ *
+ * On BOARD=native the trace given by CONFIG_SAUL_TRACE_FILE (set with
+ * `TRACE=<file>` on the make command line) is loaded at init and registered
+ * as SAUL accelerometer. Reads return the sample that was recorded at the
+ * time elapsed since the first read, so the trace is replayed in real time
+ * regardless of the rate it is sampled with.
+ *
+ * Two trace formats are understood:
+ *
+ * - CSV, one sample per line: `time_ms,x,y,z[,rep]`. Lines not starting with
+ *   a digit are skipped. `rep` is 1 on the sample a repetition was completed
+ *   and serves as ground truth for benchmarks.
+ * - Binary, starting with the magic `PTRC` followed by saul_trace_sample_t
+ *   records in little endian.
+ */
+
+#ifndef SAUL_TRACE_H
+#define SAUL_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Path of the trace on the host
+ */
+#ifndef CONFIG_SAUL_TRACE_FILE
+#define CONFIG_SAUL_TRACE_FILE          "trace.csv"
+#endif
+
+/**
+ * @brief   Maximum number of samples a trace may contain
+ */
+#ifndef CONFIG_SAUL_TRACE_MAX_SAMPLES
+#define CONFIG_SAUL_TRACE_MAX_SAMPLES   (16384U)
+#endif
+
+/**
+ * @brief   Name the simulated accelerometer is registered with
+ */
+#ifndef CONFIG_SAUL_TRACE_NAME
+#define CONFIG_SAUL_TRACE_NAME          "mma8x5x"
+#endif
+
+/**
+ * @brief   Magic at the start of a binary trace
+ */
+#define SAUL_TRACE_MAGIC                "PTRC"
+
+/**
+ * @brief   Flag marking the sample a repetition was completed
+ */
+#define SAUL_TRACE_FLAG_REP             (0x0001)
+
+/**
+ * @brief   One recorded sample, also the record layout of binary traces
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t time_ms;               /**< time since start of the recording */
+    int16_t acc[3];                 /**< x, y, z in mg */
+    uint16_t flags;                 /**< SAUL_TRACE_FLAG_* */
+} saul_trace_sample_t;
+
+/**
+ * @brief   Loads CONFIG_SAUL_TRACE_FILE and registers the accelerometer
+ *
+ * Run this exactly once during startup, before looking up the accelerometer.
+ *
+ * @return  number of samples loaded
+ * @return  negative on error
+ */
+int saul_trace_init(void);
+
+/**
+ * @brief   Restarts the replay with the next read
+ */
+void saul_trace_rewind(void);
+
+/**
+ * @brief   Number of samples in the loaded trace
+ */
+size_t saul_trace_len(void);
+
+/**
+ * @brief   Direct access to the loaded samples for offline processing
+ *
+ * @return  sample at @p idx, NULL if out of range
+ */
+const saul_trace_sample_t *saul_trace_get(size_t idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAUL_TRACE_H */
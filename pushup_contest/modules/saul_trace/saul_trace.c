@@ -0,0 +1,202 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "container.h"
+#include "native_internal.h"
+#include "phydat.h"
+#include "saul.h"
+#include "saul_reg.h"
+#include "ztimer.h"
+
+#include "saul_trace.h"
+
+#define ENABLE_DEBUG 0
+#include "debug.h"
+
+#define LINE_MAX_LEN        (64U)
+#define CHUNK_LEN           (256U)
+
+static saul_trace_sample_t _samples[CONFIG_SAUL_TRACE_MAX_SAMPLES];
+static size_t _len;
+
+static size_t _pos;
+static uint32_t _offset;
+static bool _started;
+
+static int _read(const void *dev, phydat_t *res)
+{
+    (void)dev;
+
+    if (_len == 0) {
+        return -ENODEV;
+    }
+
+    uint32_t now = ztimer_now(ZTIMER_MSEC);
+
+    if (!_started) {
+        _started = true;
+        _pos = 0;
+        _offset = now - _samples[0].time_ms;
+    }
+
+    /* advance to the last sample recorded before now, restart at the end */
+    while ((_pos + 1 < _len) && (_samples[_pos + 1].time_ms <= now - _offset)) {
+        _pos++;
+    }
+    if (_pos + 1 == _len) {
+        _started = false;
+    }
+
+    memcpy(res->val, _samples[_pos].acc, sizeof(_samples[_pos].acc));
+    res->unit = UNIT_G_FORCE;
+    res->scale = -3;
+
+    return 3;
+}
+
+static const saul_driver_t _trace_saul_driver = {
+    .read = _read,
+    .write = saul_write_notsup,
+    .type = SAUL_SENSE_ACCEL,
+};
+
+static saul_reg_t _trace_saul_reg = {
+    .name = CONFIG_SAUL_TRACE_NAME,
+    .driver = &_trace_saul_driver,
+};
+
+/* parses "time_ms,x,y,z[,rep]", returns false for anything else */
+static bool _parse_line(const char *line, saul_trace_sample_t *sample)
+{
+    long val[5] = { 0 };
+    unsigned cnt = 0;
+    char *end;
+
+    if ((*line < '0') || (*line > '9')) {
+        return false;
+    }
+
+    while (cnt < ARRAY_SIZE(val)) {
+        val[cnt++] = strtol(line, &end, 10);
+        if ((end == line) || (*end != ',')) {
+            break;
+        }
+        line = end + 1;
+    }
+
+    if (cnt < 4) {
+        return false;
+    }
+
+    sample->time_ms = val[0];
+    sample->acc[0] = val[1];
+    sample->acc[1] = val[2];
+    sample->acc[2] = val[3];
+    sample->flags = (cnt > 4 && val[4]) ? SAUL_TRACE_FLAG_REP : 0;
+
+    return true;
+}
+
+static bool _add_line(char *line, size_t line_len)
+{
+    if (_len == CONFIG_SAUL_TRACE_MAX_SAMPLES) {
+        return false;
+    }
+
+    line[line_len] = '\0';
+    if (_parse_line(line, &_samples[_len])) {
+        _len++;
+    }
+
+    return true;
+}
+
+static int _load_csv(FILE *f)
+{
+    char chunk[CHUNK_LEN];
+    char line[LINE_MAX_LEN];
+    size_t line_len = 0;
+    size_t n;
+
+    while ((n = real_fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (chunk[i] != '\n') {
+                if (line_len < sizeof(line) - 1) {
+                    line[line_len++] = chunk[i];
+                }
+                continue;
+            }
+            if (!_add_line(line, line_len)) {
+                puts("saul_trace: trace truncated");
+                return _len;
+            }
+            line_len = 0;
+        }
+    }
+
+    /* last line without trailing newline */
+    _add_line(line, line_len);
+
+    return _len;
+}
+
+static int _load_bin(FILE *f)
+{
+    _len = real_fread(_samples, sizeof(_samples[0]),
+                      CONFIG_SAUL_TRACE_MAX_SAMPLES, f);
+
+    return _len;
+}
+
+int saul_trace_init(void)
+{
+    char magic[sizeof(SAUL_TRACE_MAGIC) - 1];
+    FILE *f = real_fopen(CONFIG_SAUL_TRACE_FILE, "rb");
+    int res;
+
+    if (f == NULL) {
+        printf("saul_trace: unable to open %s\n", CONFIG_SAUL_TRACE_FILE);
+        return -ENOENT;
+    }
+
+    _len = 0;
+    if ((real_fread(magic, 1, sizeof(magic), f) == sizeof(magic))
+        && (memcmp(magic, SAUL_TRACE_MAGIC, sizeof(magic)) == 0)) {
+        res = _load_bin(f);
+    }
+    else {
+        real_fseek(f, 0, SEEK_SET);
+        res = _load_csv(f);
+    }
+    real_fclose(f);
+
+    if (res <= 0) {
+        printf("saul_trace: no samples in %s\n", CONFIG_SAUL_TRACE_FILE);
+        return -EINVAL;
+    }
+
+    DEBUG("saul_trace: loaded %d samples from %s\n", res, CONFIG_SAUL_TRACE_FILE);
+
+    saul_reg_add(&_trace_saul_reg);
+
+    return res;
+}
+
+void saul_trace_rewind(void)
+{
+    _started = false;
+}
+
+size_t saul_trace_len(void)
+{
+    return _len;
+}
+
+const saul_trace_sample_t *saul_trace_get(size_t idx)
+{
+    return (idx < _len) ? &_samples[idx] : NULL;
+}
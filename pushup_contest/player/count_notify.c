@@ -0,0 +1,203 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "event.h"
+#include "event/thread.h"
+#include "event/timeout.h"
+#include "fmt.h"
+#include "irq.h"
+#include "net/gcoap.h"
+#include "random.h"
+#include "ztimer.h"
+
+#include "count_notify.h"
+#include "stats.h"
+
+#define ENABLE_DEBUG 0
+#include "debug.h"
+
+#define COUNT_NOTIFY_QUEUE  EVENT_PRIO_MEDIUM
+
+typedef struct {
+    uint32_t count;
+    uint32_t seq;
+    uint64_t time;
+} _state_t;
+
+/* written by the game thread, read by the event thread */
+static _state_t _state;
+
+/* taken at boot, tells observers that the sequence number started over */
+static uint32_t _epoch;
+
+/* only accessed by the event thread */
+static const coap_resource_t *_resource;
+static uint32_t _sent_seq;
+static uint32_t _last_sent;
+static bool _holdoff;
+/* too large for the stack of the shared event thread */
+static uint8_t _buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+/* CON repeats of the final state left and the time until the next one */
+static unsigned _repair_left;
+static uint32_t _repair_ms;
+
+static void _on_update(event_t *ev);
+static void _on_holdoff(event_t *ev);
+static void _on_repair(event_t *ev);
+
+static event_t _ev_update = { .handler = _on_update };
+static event_t _ev_holdoff = { .handler = _on_holdoff };
+static event_t _ev_repair = { .handler = _on_repair };
+static event_timeout_t _holdoff_timeout;
+static event_timeout_t _repair_timeout;
+
+static _state_t _get_state(void)
+{
+    unsigned state = irq_disable();
+    _state_t res = _state;
+
+    irq_restore(state);
+
+    return res;
+}
+
+static size_t _format(char *buf, const _state_t *state)
+{
+    size_t len = 0;
+
+    len += fmt_u32_dec(&buf[len], state->count);
+    buf[len++] = ' ';
+    len += fmt_u32_dec(&buf[len], state->seq);
+    buf[len++] = ' ';
+    len += fmt_u64_dec(&buf[len], state->time);
+    buf[len++] = ' ';
+    len += fmt_u32_dec(&buf[len], _epoch);
+
+    return len;
+}
+
+size_t count_notify_payload(char *buf)
+{
+    _state_t state = _get_state();
+
+    return _format(buf, &state);
+}
+
+/* returns false if there is no observer */
+static bool _send(unsigned type)
+{
+    coap_pkt_t pdu;
+    size_t len;
+    _state_t state = _get_state();
+
+    /* counts as sent even without observer, there is nothing to repair */
+    _sent_seq = state.seq;
+    _last_sent = ztimer_now(ZTIMER_MSEC);
+
+    switch (gcoap_obs_init(&pdu, _buf, sizeof(_buf), _resource)) {
+    case GCOAP_OBS_INIT_OK:
+        DEBUG("count_notify: sending %s notification\n",
+              (type == COAP_TYPE_CON) ? "CON" : "NON");
+        coap_hdr_set_type(pdu.hdr, type);
+        coap_opt_add_format(&pdu, COAP_FORMAT_TEXT);
+        len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+        len += _format((char *)pdu.payload, &state);
+        if (gcoap_obs_send(_buf, len, _resource) > 0) {
+            stats_notification(STATS_NOTIFY_SENT);
+        }
+        else {
+            puts("Error sending /count notification");
+            stats_notification(STATS_NOTIFY_FAILED);
+        }
+        break;
+    case GCOAP_OBS_INIT_UNUSED:
+        DEBUG("count_notify: no observer\n");
+        stats_notification(STATS_NOTIFY_UNOBSERVED);
+        return false;
+    case GCOAP_OBS_INIT_ERR:
+        puts("Error initializing /count notification");
+        stats_notification(STATS_NOTIFY_FAILED);
+        break;
+    }
+
+    return true;
+}
+
+static void _on_update(event_t *ev)
+{
+    (void)ev;
+
+    /* every change restarts the quiet period after which it is repaired */
+    _repair_left = CONFIG_COUNT_NOTIFY_REPAIR_RETRIES;
+    _repair_ms = CONFIG_COUNT_NOTIFY_REPAIR_MS;
+    event_timeout_set(&_repair_timeout, _repair_ms);
+
+    if (_holdoff) {
+        /* the pending notification will carry the latest state */
+        return;
+    }
+
+    uint32_t since = ztimer_now(ZTIMER_MSEC) - _last_sent;
+
+    if (since >= CONFIG_COUNT_NOTIFY_MIN_INTERVAL_MS) {
+        _send(COAP_TYPE_NON);
+    }
+    else {
+        _holdoff = true;
+        event_timeout_set(&_holdoff_timeout,
+                          CONFIG_COUNT_NOTIFY_MIN_INTERVAL_MS - since);
+    }
+}
+
+static void _on_holdoff(event_t *ev)
+{
+    (void)ev;
+
+    _holdoff = false;
+    if (_get_state().seq != _sent_seq) {
+        _send(COAP_TYPE_NON);
+    }
+}
+
+static void _on_repair(event_t *ev)
+{
+    (void)ev;
+
+    /* gcoap neither retransmits a CON notification nor tells about its ACK,
+     * so the state is repeated a few times, observers drop duplicates by
+     * their sequence number */
+    if ((_repair_left == 0) || !_send(COAP_TYPE_CON)) {
+        return;
+    }
+    if (--_repair_left > 0) {
+        _repair_ms *= 2;
+        event_timeout_set(&_repair_timeout, _repair_ms);
+    }
+}
+
+void count_notify_init(const coap_resource_t *resource)
+{
+    _resource = resource;
+    _epoch = random_uint32();
+
+    event_timeout_ztimer_init(&_holdoff_timeout, ZTIMER_MSEC,
+                              COUNT_NOTIFY_QUEUE, &_ev_holdoff);
+    event_timeout_ztimer_init(&_repair_timeout, ZTIMER_MSEC,
+                              COUNT_NOTIFY_QUEUE, &_ev_repair);
+}
+
+void count_notify_update(uint32_t count, uint64_t time)
+{
+    unsigned state = irq_disable();
+
+    _state.count = count;
+    _state.seq++;
+    _state.time = time;
+
+    irq_restore(state);
+
+    /* posting an event that is still queued does nothing, so bursts of
+     * updates before the event thread runs are coalesced right here */
+    event_post(COUNT_NOTIFY_QUEUE, &_ev_update);
+}
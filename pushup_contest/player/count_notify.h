@@ -0,0 +1,89 @@
+/**
+ * @file
+ * @brief       Scheduler of the /count Observe notifications
+ *
+ * The payload (text/plain) of /count is `<count> <seq> <time> <epoch>`: the
+ * current count, a sequence number incremented with every change of the
+ * count (including resets), the time of that change in us in the timebase of
+ * timesync_now() and a random number taken at boot. For a detected rep the
+ * time is when the player was up again. The sequence number lets observers
+ * discard reordered notifications, it starts over with a new epoch after a
+ * reboot.
+ *
+ * Changes are coalesced: the first change is notified right away as NON,
+ * further changes within CONFIG_COUNT_NOTIFY_MIN_INTERVAL_MS are merged into
+ * one notification carrying the latest state. Once the count has not changed
+ * for CONFIG_COUNT_NOTIFY_REPAIR_MS the final state is sent again as CON, up
+ * to CONFIG_COUNT_NOTIFY_REPAIR_RETRIES times with the interval doubling each
+ * time. gcoap does not retransmit notifications, so this repairs a lost last
+ * rep of a burst (the winning one) unless all repeats are lost as well.
+ */
+
+#ifndef COUNT_NOTIFY_H
+#define COUNT_NOTIFY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net/gcoap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Minimum time between two NON notifications in ms
+ */
+#ifndef CONFIG_COUNT_NOTIFY_MIN_INTERVAL_MS
+#define CONFIG_COUNT_NOTIFY_MIN_INTERVAL_MS     (100U)
+#endif
+
+/**
+ * @brief   Time without change after which the state is repeated as CON in ms
+ */
+#ifndef CONFIG_COUNT_NOTIFY_REPAIR_MS
+#define CONFIG_COUNT_NOTIFY_REPAIR_MS           (1000U)
+#endif
+
+/**
+ * @brief   How often the final state is repeated as CON
+ */
+#ifndef CONFIG_COUNT_NOTIFY_REPAIR_RETRIES
+#define CONFIG_COUNT_NOTIFY_REPAIR_RETRIES      (3U)
+#endif
+
+/**
+ * @brief   Maximum length of the payload
+ */
+#define COUNT_NOTIFY_PAYLOAD_MAX    (3 * 10 + 20 + 3)
+
+/**
+ * @brief   Sets up notifications for the /count resource
+ */
+void count_notify_init(const coap_resource_t *resource);
+
+/**
+ * @brief   Records a new count and schedules its notification
+ *
+ * Cheap and non-blocking, meant to be called by the game thread. Matches
+ * game_count_cb_t.
+ *
+ * @param[in] count     the new count
+ * @param[in] time      when the count changed, see timesync_now()
+ */
+void count_notify_update(uint32_t count, uint64_t time);
+
+/**
+ * @brief   Writes the payload for the current state to @p buf
+ *
+ * @param[out] buf  at least COUNT_NOTIFY_PAYLOAD_MAX bytes
+ *
+ * @return  length of the payload
+ */
+size_t count_notify_payload(char *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COUNT_NOTIFY_H */
@@ -0,0 +1,122 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "irq.h"
+#include "thread.h"
+#include "ztimer.h"
+
+#include "dlog.h"
+#include "stats.h"
+
+#if CONFIG_DLOG_LEVEL > DLOG_LEVEL_NONE
+
+#define DLOG_BUF_MASK   (CONFIG_DLOG_BUF_SIZE - 1)
+
+static_assert((CONFIG_DLOG_BUF_SIZE & DLOG_BUF_MASK) == 0,
+              "CONFIG_DLOG_BUF_SIZE must be a power of two");
+
+static const char *_names[DLOG_ID_NUMOF] = {
+    [DLOG_ID_SAMPLE] = "sample",
+    [DLOG_ID_START] = "start",
+    [DLOG_ID_STOP] = "stop",
+    [DLOG_ID_CALIBRATED] = "calibrated",
+    [DLOG_ID_DOWN] = "down",
+    [DLOG_ID_UP] = "up",
+    [DLOG_ID_REP] = "repetition",
+};
+
+/* records are formatted with printf() */
+static char _stack[THREAD_STACKSIZE_DEFAULT + THREAD_EXTRA_STACKSIZE_PRINTF];
+
+static dlog_record_t _buf[CONFIG_DLOG_BUF_SIZE];
+static unsigned _head;
+static unsigned _tail;
+static unsigned _lost;
+
+void dlog_write(dlog_id_t id, int16_t a, int16_t b, int16_t c)
+{
+    uint32_t now = ztimer_now(ZTIMER_USEC);
+    unsigned state = irq_disable();
+
+    if (_head - _tail == CONFIG_DLOG_BUF_SIZE) {
+        _lost++;
+    }
+    else {
+        dlog_record_t *rec = &_buf[_head++ & DLOG_BUF_MASK];
+        rec->time = now;
+        rec->id = id;
+        rec->arg[0] = a;
+        rec->arg[1] = b;
+        rec->arg[2] = c;
+    }
+
+    irq_restore(state);
+}
+
+static bool _pop(dlog_record_t *rec, unsigned *lost)
+{
+    unsigned state = irq_disable();
+    bool res = (_head != _tail);
+
+    if (res) {
+        *rec = _buf[_tail++ & DLOG_BUF_MASK];
+    }
+    *lost = _lost;
+    _lost = 0;
+
+    irq_restore(state);
+
+    return res;
+}
+
+static void _print(const dlog_record_t *rec)
+{
+    switch (rec->id) {
+    case DLOG_ID_SAMPLE:
+        printf("%" PRIu32 " %d %d %d\n", rec->time,
+               rec->arg[0], rec->arg[1], rec->arg[2]);
+        break;
+    case DLOG_ID_STOP:
+    case DLOG_ID_REP:
+        printf("%" PRIu32 " %s %d\n", rec->time, _names[rec->id], rec->arg[0]);
+        break;
+    default:
+        printf("%" PRIu32 " %s\n", rec->time,
+               (rec->id < DLOG_ID_NUMOF) ? _names[rec->id] : "?");
+        break;
+    }
+}
+
+static void *_drain_thread(void *arg)
+{
+    (void)arg;
+
+    dlog_record_t rec;
+    unsigned lost;
+
+    while (1) {
+        ztimer_sleep(ZTIMER_MSEC, CONFIG_DLOG_DRAIN_MS);
+
+        while (_pop(&rec, &lost)) {
+            if (lost) {
+                printf("dlog: %u records lost\n", lost);
+            }
+            _print(&rec);
+        }
+    }
+
+    return NULL;
+}
+
+void dlog_init(void)
+{
+    kernel_pid_t pid = thread_create(_stack, sizeof(_stack), THREAD_PRIORITY_IDLE - 1,
+                                     THREAD_CREATE_STACKTEST, _drain_thread, NULL,
+                                     "dlog");
+    stats_watch_stack(pid);
+}
+
+#endif /* CONFIG_DLOG_LEVEL > DLOG_LEVEL_NONE */
@@ -0,0 +1,114 @@
+/**
+ * @file
+ * @brief       Deferred binary logging
+ *
+ * Log calls only append a fixed-size binary record to a RAM ring buffer. A
+ * thread at the lowest priority formats and prints the records when the CPU
+ * is otherwise idle, so logging costs no formatting or UART time where it is
+ * called. Records above CONFIG_DLOG_LEVEL are compiled out entirely,
+ * including the evaluation of their arguments.
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @name    Log levels
+ * @{
+ */
+#define DLOG_LEVEL_NONE         (0)     /**< nothing is logged */
+#define DLOG_LEVEL_EVENT        (1)     /**< game and detection events */
+#define DLOG_LEVEL_SAMPLE       (2)     /**< additionally every sample */
+/** @} */
+
+/**
+ * @brief   Records up to this level are logged
+ */
+#ifndef CONFIG_DLOG_LEVEL
+#define CONFIG_DLOG_LEVEL       DLOG_LEVEL_EVENT
+#endif
+
+/**
+ * @brief   Number of records the buffer holds, must be a power of two
+ */
+#ifndef CONFIG_DLOG_BUF_SIZE
+#define CONFIG_DLOG_BUF_SIZE    (64U)
+#endif
+
+/**
+ * @brief   Interval in which the buffer is drained in ms
+ */
+#ifndef CONFIG_DLOG_DRAIN_MS
+#define CONFIG_DLOG_DRAIN_MS    (100U)
+#endif
+
+/**
+ * @brief   What a record is about, determines how its arguments are printed
+ */
+typedef enum {
+    DLOG_ID_SAMPLE,             /**< x, y, z */
+    DLOG_ID_START,              /**< detection started */
+    DLOG_ID_STOP,               /**< detection stopped, new phase */
+    DLOG_ID_CALIBRATED,         /**< detector calibrated */
+    DLOG_ID_DOWN,               /**< player went down */
+    DLOG_ID_UP,                 /**< player came up */
+    DLOG_ID_REP,                /**< repetition counted, count */
+    DLOG_ID_NUMOF,              /**< number of record ids */
+} dlog_id_t;
+
+/**
+ * @brief   One log record
+ */
+typedef struct {
+    uint32_t time;              /**< time of the log call in us */
+    uint16_t id;                /**< dlog_id_t */
+    int16_t arg[3];             /**< id specific arguments */
+} dlog_record_t;
+
+#if (CONFIG_DLOG_LEVEL > DLOG_LEVEL_NONE) || defined(DOXYGEN)
+/**
+ * @brief   Starts the drain thread
+ *
+ * Run this exactly once during startup.
+ */
+void dlog_init(void);
+
+/**
+ * @brief   Appends a record, safe to call from any context
+ *
+ * Use the DLOG_* macros instead so the call can be compiled out.
+ */
+void dlog_write(dlog_id_t id, int16_t a, int16_t b, int16_t c);
+#else
+static inline void dlog_init(void) {}
+#endif
+
+#if CONFIG_DLOG_LEVEL >= DLOG_LEVEL_EVENT
+/**
+ * @brief   Logs a game or detection event
+ */
+#define DLOG_EVENT(id, a, b, c)     dlog_write(id, a, b, c)
+#else
+#define DLOG_EVENT(id, a, b, c)     do {} while (0)
+#endif
+
+#if CONFIG_DLOG_LEVEL >= DLOG_LEVEL_SAMPLE
+/**
+ * @brief   Logs a sample
+ */
+#define DLOG_SAMPLE(x, y, z)        dlog_write(DLOG_ID_SAMPLE, x, y, z)
+#else
+#define DLOG_SAMPLE(x, y, z)        do {} while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DLOG_H */
@@ -0,0 +1,385 @@
+#include <errno.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "event.h"
+#include "event/timeout.h"
+#include "net/gcoap.h"
+#include "saul_reg.h"
+#include "thread.h"
+#include "thread_flags.h"
+#include "ztimer.h"
+
+#include "detector.h"
+#include "dlog.h"
+#include "game.h"
+#include "journal.h"
+#include "led.h"
+#include "reps.h"
+#include "sampler.h"
+#include "stats.h"
+#include "timesync.h"
+
+#if IS_USED(MODULE_SAUL_TRACE)
+#include "saul_trace.h"
+#endif
+
+#define ENABLE_DEBUG 0
+#include "debug.h"
+
+#define SAUL_ACCELEROMETER_NAME ("mma8x5x")
+
+/* the samples callback builds its notification on this stack */
+static char _stack[THREAD_STACKSIZE_MAIN + CONFIG_GCOAP_PDU_BUF_SIZE];
+static event_queue_t _queue = EVENT_QUEUE_INIT_DETACHED;
+
+/* posts _ev_start at the time given to game_start_at() */
+static event_timeout_t _start_timeout;
+
+static game_count_cb_t _count_cb;
+static game_samples_cb_t _samples_cb;
+
+/* written by the worker thread only */
+static volatile uint32_t _count;
+static volatile game_phase_t _phase = GAME_PHASE_IDLE;
+
+/* repetitions injected via game_add_rep() not yet counted */
+static atomic_uint _added_reps;
+
+/* written by the CoAP handler, applied by the worker thread */
+static volatile led_color_t _color = LED_COLOR_OFF;
+
+/* CONFIG_DETECTOR_WINDOW selects the legacy fixed window detection */
+#if IS_ACTIVE(CONFIG_DETECTOR_WINDOW)
+static detector_window_t _detector;
+#else
+static detector_iir_t _detector;
+#endif
+
+/* keeps the state across resets of the node */
+static void _persist(void)
+{
+    journal_state_t state = {
+        .count = _count,
+        .color = _color,
+        .phase = _phase,
+    };
+
+    journal_append(&state);
+}
+
+static void _stop_counting(game_phase_t phase)
+{
+    if (phase != GAME_PHASE_COUNTING) {
+        event_timeout_clear(&_start_timeout);
+    }
+    if (_phase == GAME_PHASE_COUNTING) {
+        sampler_stop();
+        DLOG_EVENT(DLOG_ID_STOP, phase, 0, 0);
+    }
+    _phase = phase;
+    _persist();
+}
+
+/* the LED shows the player color unless the game is decided */
+static bool _shows_color(void)
+{
+    return (_phase == GAME_PHASE_IDLE) || (_phase == GAME_PHASE_COUNTING);
+}
+
+/* real and injected repetitions are counted the same way */
+static void _count_rep(uint64_t time)
+{
+    if (_shows_color()) {
+        led_rep_flash();
+    }
+
+    /* update pushups counter and notify observers */
+    _count++;
+    _persist();
+    _count_cb(_count, time);
+}
+
+static void _on_color(event_t *ev)
+{
+    (void)ev;
+
+    if (_shows_color()) {
+        led_solid(_color);
+    }
+    _persist();
+}
+
+static void _on_start(event_t *ev)
+{
+    (void)ev;
+
+    DLOG_EVENT(DLOG_ID_START, 0, 0, 0);
+
+    _stop_counting(GAME_PHASE_COUNTING);
+
+    /* the engine calibrates first, the player has to hold still */
+    led_pulse(_color);
+
+#if IS_USED(MODULE_SAUL_TRACE)
+    saul_trace_rewind();
+#endif
+    detector_reset(&_detector.super);
+    sampler_start(thread_getpid());
+}
+
+static void _on_stop(event_t *ev)
+{
+    (void)ev;
+
+    _stop_counting(GAME_PHASE_IDLE);
+    led_solid(_color);
+}
+
+static void _on_reset(event_t *ev)
+{
+    (void)ev;
+
+    /* cleared first, so the state is persisted once */
+    _count = 0;
+    _stop_counting(GAME_PHASE_IDLE);
+    led_solid(_color);
+
+    reps_reset();
+    _count_cb(_count, timesync_now());
+}
+
+static void _on_win(event_t *ev)
+{
+    (void)ev;
+
+    _stop_counting(GAME_PHASE_WINNER);
+    led_blink(_color);
+}
+
+static void _on_lose(event_t *ev)
+{
+    (void)ev;
+
+    _stop_counting(GAME_PHASE_LOOSER);
+    led_solid(LED_COLOR_OFF);
+}
+
+static void _on_rep(event_t *ev)
+{
+    (void)ev;
+
+    for (unsigned n = atomic_exchange(&_added_reps, 0); n > 0; n--) {
+        _count_rep(timesync_now());
+    }
+}
+
+static event_t _ev_color = { .handler = _on_color };
+static event_t _ev_start = { .handler = _on_start };
+static event_t _ev_stop = { .handler = _on_stop };
+static event_t _ev_reset = { .handler = _on_reset };
+static event_t _ev_win = { .handler = _on_win };
+static event_t _ev_lose = { .handler = _on_lose };
+static event_t _ev_rep = { .handler = _on_rep };
+
+/* continues the game the node was in before it was reset */
+static void _restore(void)
+{
+    journal_state_t state;
+
+    if (journal_init(&state) < 0) {
+        return;
+    }
+
+    printf("Restored count %" PRIu32 ", color %u, phase %u\n",
+           state.count, state.color, state.phase);
+
+    _count = state.count;
+    /* older firmware journaled whatever color it was sent */
+    _color = (state.color <= LED_COLOR_BLUE) ? (led_color_t)state.color : LED_COLOR_OFF;
+
+    switch ((game_phase_t)state.phase) {
+    case GAME_PHASE_COUNTING:
+        /* handled once the worker thread runs, recalibrates first */
+        event_post(&_queue, &_ev_start);
+        break;
+    case GAME_PHASE_WINNER:
+        _phase = GAME_PHASE_WINNER;
+        led_blink(_color);
+        break;
+    case GAME_PHASE_LOOSER:
+        _phase = GAME_PHASE_LOOSER;
+        led_solid(LED_COLOR_OFF);
+        break;
+    case GAME_PHASE_IDLE:
+    default:
+        /* without color the player was never assigned and stays blue */
+        if (_color != LED_COLOR_OFF) {
+            led_solid(_color);
+        }
+        break;
+    }
+
+    _count_cb(_count, timesync_now());
+}
+
+static void _process_samples(void)
+{
+    accel_sample_t sample;
+    const detector_rep_t *rep;
+
+    while (sampler_pop(&sample)) {
+        if (_phase != GAME_PHASE_COUNTING) {
+            continue;
+        }
+
+        DLOG_SAMPLE(sample.acc[0], sample.acc[1], sample.acc[2]);
+
+        detector_event_t event = detector_process(&_detector.super, &sample);
+
+        stats_detection_latency(ztimer_now(ZTIMER_USEC) - sample.time);
+
+        switch (event) {
+        case DETECTOR_EVENT_NONE:
+            break;
+        case DETECTOR_EVENT_CALIBRATED:
+            DLOG_EVENT(DLOG_ID_CALIBRATED, 0, 0, 0);
+            led_solid(_color);
+            break;
+        case DETECTOR_EVENT_DOWN:
+            DLOG_EVENT(DLOG_ID_DOWN, 0, 0, 0);
+            break;
+        case DETECTOR_EVENT_UP:
+            DLOG_EVENT(DLOG_ID_UP, 0, 0, 0);
+            break;
+        case DETECTOR_EVENT_REP:
+            rep = detector_last_rep(&_detector.super);
+            reps_add(rep);
+            _count_rep(timesync_from_usec(rep->end));
+            DLOG_EVENT(DLOG_ID_REP, _count, 0, 0);
+            break;
+        }
+    }
+}
+
+static void *_game_thread(void *arg)
+{
+    (void)arg;
+
+    event_queue_claim(&_queue);
+
+    while (1) {
+        thread_flags_t flags = thread_flags_wait_any(THREAD_FLAG_EVENT |
+                                                     SAMPLER_FLAG_DATA);
+
+        if (flags & THREAD_FLAG_EVENT) {
+            event_t *ev;
+            while ((ev = event_get(&_queue))) {
+                ev->handler(ev);
+            }
+        }
+        if (flags & SAMPLER_FLAG_DATA) {
+            _process_samples();
+            _samples_cb();
+        }
+    }
+
+    return NULL;
+}
+
+void game_init(game_count_cb_t count_cb, game_samples_cb_t samples_cb)
+{
+    _count_cb = count_cb;
+    _samples_cb = samples_cb;
+
+#if IS_USED(MODULE_SAUL_TRACE)
+    saul_trace_init();
+#endif
+#if IS_ACTIVE(CONFIG_DETECTOR_WINDOW)
+    detector_window_init(&_detector, CONFIG_SAMPLER_RATE_HZ);
+#else
+    detector_iir_init(&_detector, CONFIG_SAMPLER_RATE_HZ);
+#endif
+    sampler_init(saul_reg_find_name(SAUL_ACCELEROMETER_NAME));
+    event_timeout_ztimer_init(&_start_timeout, ZTIMER_USEC, &_queue, &_ev_start);
+    _restore();
+
+    kernel_pid_t pid = thread_create(_stack, sizeof(_stack), THREAD_PRIORITY_MAIN - 1,
+                                     THREAD_CREATE_STACKTEST, _game_thread, NULL,
+                                     "pushup_detection_thread");
+    stats_watch_stack(pid);
+}
+
+void game_assign_color(led_color_t color)
+{
+    _color = color;
+    event_post(&_queue, &_ev_color);
+}
+
+void game_start(void)
+{
+    event_post(&_queue, &_ev_start);
+}
+
+int game_start_at(uint64_t time)
+{
+    /* the local clock alone would start at an arbitrary time */
+    if (!timesync_synced()) {
+        return -EAGAIN;
+    }
+
+    uint64_t now = timesync_now();
+
+    /* a late command would start the players at different times */
+    if ((time <= now) || (time - now > UINT32_MAX)) {
+        return -EINVAL;
+    }
+
+    event_timeout_set(&_start_timeout, (uint32_t)(time - now));
+
+    return 0;
+}
+
+void game_stop(void)
+{
+    event_post(&_queue, &_ev_stop);
+}
+
+void game_reset(void)
+{
+    event_post(&_queue, &_ev_reset);
+}
+
+void game_win(void)
+{
+    event_post(&_queue, &_ev_win);
+}
+
+void game_lose(void)
+{
+    event_post(&_queue, &_ev_lose);
+}
+
+void game_add_rep(void)
+{
+    atomic_fetch_add(&_added_reps, 1);
+    event_post(&_queue, &_ev_rep);
+}
+
+uint32_t game_count(void)
+{
+    return _count;
+}
+
+game_phase_t game_phase(void)
+{
+    return _phase;
+}
+
+led_color_t game_color(void)
+{
+    return _color;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file
+ * @brief       Game state of the player
+ *
+ * A long-lived worker thread owns the game state and runs the pushup
+ * detection. Commands are posted to its event queue and return at once, so
+ * they are safe to call from CoAP handlers at any time.
+ */
+
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdint.h>
+
+#include "led.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Phases of a game as seen by the player
+ */
+typedef enum {
+    GAME_PHASE_IDLE,                /**< waiting for start */
+    GAME_PHASE_COUNTING,            /**< counting pushups */
+    GAME_PHASE_WINNER,              /**< game over, this player won */
+    GAME_PHASE_LOOSER,              /**< game over, this player lost */
+} game_phase_t;
+
+/**
+ * @brief   Called from the worker thread whenever the count changed
+ *
+ * @param[in] count     the new count
+ * @param[in] time      when the change happened, in the timebase of
+ *                      timesync_now()
+ */
+typedef void (*game_count_cb_t)(uint32_t count, uint64_t time);
+
+/**
+ * @brief   Called from the worker thread after new samples were processed
+ */
+typedef void (*game_samples_cb_t)(void);
+
+/**
+ * @brief   Sets up detection and starts the worker thread
+ *
+ * Restores the game state saved in the journal, @p count_cb is called with
+ * the restored count. Run this exactly once during startup.
+ *
+ * @param[in] count_cb      called on every change of the pushup count
+ * @param[in] samples_cb    called after new samples were processed
+ */
+void game_init(game_count_cb_t count_cb, game_samples_cb_t samples_cb);
+
+/**
+ * @brief   Assigns the player color and shows it
+ */
+void game_assign_color(led_color_t color);
+
+/**
+ * @brief   Starts counting, restarts the detection if already counting
+ */
+void game_start(void);
+
+/**
+ * @brief   Starts counting at a given time
+ *
+ * A scheduled start is canceled by stopping, resetting or deciding the game.
+ *
+ * @param[in] time  start time in the timebase of timesync_now()
+ *
+ * @return  0 on success
+ * @return  -EAGAIN if the clock was not synchronized yet, see
+ *          timesync_synced()
+ * @return  -EINVAL if @p time is in the past or too far in the future
+ */
+int game_start_at(uint64_t time);
+
+/**
+ * @brief   Stops counting, the count is kept
+ */
+void game_stop(void);
+
+/**
+ * @brief   Stops counting and sets the count back to zero
+ */
+void game_reset(void);
+
+/**
+ * @brief   Stops counting and lets the LED blink in the player color
+ */
+void game_win(void);
+
+/**
+ * @brief   Stops counting and switches the LED off
+ */
+void game_lose(void);
+
+/**
+ * @brief   Counts a repetition that was not detected from the accelerometer
+ *
+ * The repetition takes the same path as a detected one, including LED
+ * feedback and observer notification. Calls are never merged.
+ */
+void game_add_rep(void);
+
+/**
+ * @brief   Current pushup count
+ */
+uint32_t game_count(void);
+
+/**
+ * @brief   Current phase of the game
+ */
+game_phase_t game_phase(void);
+
+/**
+ * @brief   Color assigned to the player
+ */
+led_color_t game_color(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GAME_H */
@@ -0,0 +1,167 @@
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "net/gcoap.h"
+#include "net/gnrc/netif.h"
+#include "net/ipv6/addr.h"
+
+#include "game.h"
+#include "group.h"
+
+#define GROUP_PAYLOAD_MAX_LEN   (64U)
+
+/* only accessed by the gcoap thread */
+static uint32_t _last_id;
+static bool _has_last_id;
+
+int group_init(gnrc_netif_t *netif)
+{
+    ipv6_addr_t addr;
+
+    if ((netif == NULL) || (ipv6_addr_from_str(&addr, CONFIG_GROUP_ADDR) == NULL)) {
+        return -EINVAL;
+    }
+
+    return gnrc_netif_ipv6_group_join(netif, &addr);
+}
+
+/* the player wins if its color is in the space separated list */
+static void _result(const char *colors)
+{
+    led_color_t own = game_color();
+    char *end;
+
+    while (*colors != '\0') {
+        unsigned long color = strtoul(colors, &end, 10);
+        if (end == colors) {
+            break;
+        }
+        if (color == (unsigned long)own) {
+            game_win();
+            return;
+        }
+        colors = end;
+    }
+
+    game_lose();
+}
+
+/* the start time is in the timebase of timesync_now() */
+static int _start_at(const char *time)
+{
+    char *end;
+
+    /* strtoull() accepts a sign and leading white space */
+    if (!isdigit((unsigned char)*time)) {
+        return -EINVAL;
+    }
+    errno = 0;
+    unsigned long long start = strtoull(time, &end, 10);
+    if ((*end != '\0') || (errno == ERANGE)) {
+        return -EINVAL;
+    }
+
+    return game_start_at(start);
+}
+
+static int _execute(const char *cmd, const char *args)
+{
+    if (strcmp(cmd, "start") == 0) {
+        if (*args == '\0') {
+            game_start();
+            return 0;
+        }
+        return _start_at(args);
+    }
+    if (strcmp(cmd, "stop") == 0) {
+        game_stop();
+        return 0;
+    }
+    if (strcmp(cmd, "reset") == 0) {
+        game_reset();
+        return 0;
+    }
+    if (strcmp(cmd, "result") == 0) {
+        _result(args);
+        return 0;
+    }
+
+    return -EINVAL;
+}
+
+static ssize_t _post(coap_pkt_t *pdu, uint8_t *buf, size_t len)
+{
+    char payload[GROUP_PAYLOAD_MAX_LEN + 1];
+    char *pos;
+
+    if (pdu->payload_len > GROUP_PAYLOAD_MAX_LEN) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_REQUEST_ENTITY_TOO_LARGE);
+    }
+    memcpy(payload, pdu->payload, pdu->payload_len);
+    payload[pdu->payload_len] = '\0';
+
+    /* "<id> <command> [<args>]" */
+    uint32_t id = strtoul(payload, &pos, 10);
+    if ((pos == payload) || (*pos != ' ')) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+    }
+
+    char *cmd = pos + 1;
+    char *args = strchr(cmd, ' ');
+    if (args != NULL) {
+        *args++ = '\0';
+    }
+    else {
+        args = cmd + strlen(cmd);
+    }
+
+    /* repeated by unicast for players that missed the multicast */
+    if (_has_last_id && (id == _last_id)) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
+    }
+
+    printf("COAP: Group %s\n", cmd);
+
+    if (_execute(cmd, args) < 0) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+    }
+
+    _last_id = id;
+    _has_last_id = true;
+
+    return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
+}
+
+static ssize_t _get(coap_pkt_t *pdu, uint8_t *buf, size_t len)
+{
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_TEXT);
+    size_t resp_len = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+
+    if (!_has_last_id) {
+        return resp_len;
+    }
+
+    return resp_len + fmt_u32_dec((char *)pdu->payload, _last_id);
+}
+
+ssize_t group_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                      coap_request_ctx_t *ctx)
+{
+    (void)ctx;
+
+    switch (coap_method2flag(coap_get_code_detail(pdu))) {
+    case COAP_GET:
+        return _get(pdu, buf, len);
+    case COAP_POST:
+        return _post(pdu, buf, len);
+    default:
+        return gcoap_response(pdu, buf, len, COAP_CODE_METHOD_NOT_ALLOWED);
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @brief       Group control of all players via multicast
+ *
+ * Every player joins the multicast group CONFIG_GROUP_ADDR, so the referee
+ * controls the whole fleet with a single request to /group. The payload
+ * (text/plain) of a POST is `<id> <command> [<args>]`:
+ *
+ *      <id> start [<time>]     start counting at time (see timesync_now()),
+ *                              right away without time. A time is rejected
+ *                              with 4.00 until the clock was synchronized
+ *      <id> stop               stop counting
+ *      <id> reset              reset the count
+ *      <id> result <color>...  players with one of the colors won, the
+ *                              others lost
+ *
+ * The id identifies the command. A command with the id of the last command
+ * executed is acknowledged but not executed again, so the referee may repeat
+ * it by unicast to players that missed the multicast. GET returns the id of
+ * the last command executed, which the referee uses to collect
+ * acknowledgements.
+ */
+
+#ifndef GROUP_H
+#define GROUP_H
+
+#include "net/gcoap.h"
+#include "net/gnrc/netif.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Multicast group the players join
+ */
+#ifndef CONFIG_GROUP_ADDR
+#define CONFIG_GROUP_ADDR       "ff02::7075"
+#endif
+
+/**
+ * @brief   Joins the group on @p netif
+ *
+ * @return  0 on success, negative on error
+ */
+int group_init(gnrc_netif_t *netif);
+
+/**
+ * @brief   CoAP handler of the /group resource
+ */
+ssize_t group_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                      coap_request_ctx_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GROUP_H */
@@ -0,0 +1,270 @@
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "board.h"
+
+#include "journal.h"
+
+#ifdef MTD_0
+
+#include "checksum/fletcher16.h"
+#include "mtd.h"
+
+#define ENABLE_DEBUG 0
+#include "debug.h"
+
+#define JOURNAL_MAGIC       (0x4e524a50UL)  /* "PJRN" */
+#define JOURNAL_SECTORS     (2U)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t generation;
+} _header_t;
+
+/* flash allows only clearing bits, so a record is written exactly once */
+typedef struct __attribute__((packed)) {
+    uint32_t count;
+    uint8_t color;
+    uint8_t phase;
+    uint16_t check;
+} _record_t;
+
+/* the header takes the first record slot of a sector */
+static_assert(sizeof(_header_t) == sizeof(_record_t),
+              "header and record must have the same size");
+
+static mtd_dev_t *_mtd;
+static uint32_t _first_sector;
+static uint32_t _slots;
+
+static unsigned _active;
+static uint32_t _generation;
+static uint32_t _next;
+
+static journal_state_t _last;
+static bool _has_last;
+
+static uint32_t _addr(unsigned sector, uint32_t slot)
+{
+    uint32_t sector_size = _mtd->pages_per_sector * _mtd->page_size;
+
+    return (_first_sector + sector) * sector_size + slot * sizeof(_record_t);
+}
+
+static int _read(void *buf, uint32_t addr, uint32_t len)
+{
+    return mtd_read_page(_mtd, buf, addr / _mtd->page_size,
+                         addr % _mtd->page_size, len);
+}
+
+static int _write(const void *buf, uint32_t addr, uint32_t len)
+{
+    return mtd_write_page_raw(_mtd, buf, addr / _mtd->page_size,
+                              addr % _mtd->page_size, len);
+}
+
+static uint16_t _checksum(const _record_t *rec)
+{
+    return fletcher16((const uint8_t *)rec, offsetof(_record_t, check));
+}
+
+static bool _is_erased(const void *buf, size_t len)
+{
+    const uint8_t *bytes = buf;
+
+    for (size_t i = 0; i < len; i++) {
+        if (bytes[i] != 0xff) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool _read_header(unsigned sector, uint32_t *generation)
+{
+    _header_t hdr;
+
+    if ((_read(&hdr, _addr(sector, 0), sizeof(hdr)) < 0)
+        || (hdr.magic != JOURNAL_MAGIC)) {
+        return false;
+    }
+
+    *generation = hdr.generation;
+
+    return true;
+}
+
+static int _format(unsigned sector, uint32_t generation)
+{
+    _header_t hdr = { .magic = JOURNAL_MAGIC, .generation = generation };
+    int res = mtd_erase_sector(_mtd, _first_sector + sector, 1);
+
+    if (res < 0) {
+        return res;
+    }
+
+    DEBUG("journal: sector %u is generation %" PRIu32 "\n", sector, generation);
+
+    return _write(&hdr, _addr(sector, 0), sizeof(hdr));
+}
+
+/* finds the last valid record and the first free slot of a sector */
+static int _scan(unsigned sector, journal_state_t *state, uint32_t *next)
+{
+    int res = -ENOENT;
+    uint32_t slot;
+
+    for (slot = 1; slot < _slots; slot++) {
+        _record_t rec;
+        int err = _read(&rec, _addr(sector, slot), sizeof(rec));
+
+        if (err < 0) {
+            return err;
+        }
+        if (_is_erased(&rec, sizeof(rec))) {
+            break;
+        }
+        /* torn records are skipped, their slot stays used */
+        if (rec.check == _checksum(&rec)) {
+            state->count = rec.count;
+            state->color = rec.color;
+            state->phase = rec.phase;
+            res = 0;
+        }
+    }
+
+    *next = slot;
+
+    return res;
+}
+
+int journal_init(journal_state_t *state)
+{
+    uint32_t generation[JOURNAL_SECTORS];
+    bool valid[JOURNAL_SECTORS];
+    int res;
+
+    mtd_dev_t *mtd = MTD_0;
+    uint32_t slots;
+
+    /* _mtd stays NULL until the journal area is known, journal_append()
+     * must not touch the device before */
+    res = mtd_init(mtd);
+    if (res < 0) {
+        return res;
+    }
+    slots = (mtd->pages_per_sector * mtd->page_size) / sizeof(_record_t);
+    /* a sector holds the header and at least one record */
+    if ((mtd->sector_count < JOURNAL_SECTORS) || (slots < 2)) {
+        return -ENOSPC;
+    }
+
+    _mtd = mtd;
+    _first_sector = mtd->sector_count - JOURNAL_SECTORS;
+    _slots = slots;
+
+    for (unsigned i = 0; i < JOURNAL_SECTORS; i++) {
+        valid[i] = _read_header(i, &generation[i]);
+    }
+
+    if (!valid[0] && !valid[1]) {
+        puts("journal: formatting");
+        _active = 0;
+        _generation = 1;
+        _next = 1;
+        res = _format(_active, _generation);
+        if (res < 0) {
+            _mtd = NULL;
+            return res;
+        }
+        return -ENOENT;
+    }
+
+    _active = (valid[0] && (!valid[1]
+                            || (int32_t)(generation[0] - generation[1]) > 0))
+              ? 0 : 1;
+    _generation = generation[_active];
+
+    res = _scan(_active, &_last, &_next);
+    if ((res == -ENOENT) && valid[!_active]) {
+        /* reset while compacting, before the first record was written */
+        uint32_t unused;
+        res = _scan(!_active, &_last, &unused);
+    }
+
+    if (res == 0) {
+        _has_last = true;
+        *state = _last;
+    }
+
+    return res;
+}
+
+int journal_append(const journal_state_t *state)
+{
+    if (_mtd == NULL) {
+        return -ENODEV;
+    }
+
+    if (_has_last && (state->count == _last.count)
+        && (state->color == _last.color) && (state->phase == _last.phase)) {
+        return 0;
+    }
+
+    _record_t rec = {
+        .count = state->count,
+        .color = state->color,
+        .phase = state->phase,
+    };
+    rec.check = _checksum(&rec);
+
+    /* each record holds the whole state, so compacting is starting over in
+     * the other sector, the full one is only erased when it is next used */
+    if (_next >= _slots) {
+        unsigned other = !_active;
+        int res = _format(other, _generation + 1);
+
+        if (res < 0) {
+            return res;
+        }
+        _active = other;
+        _generation++;
+        _next = 1;
+    }
+
+    int res = _write(&rec, _addr(_active, _next), sizeof(rec));
+
+    /* a failed write may have left bits cleared, never reuse the slot */
+    _next++;
+
+    if (res == 0) {
+        _last = *state;
+        _has_last = true;
+    }
+
+    return res;
+}
+
+#else /* MTD_0 */
+
+int journal_init(journal_state_t *state)
+{
+    (void)state;
+
+    return -ENOTSUP;
+}
+
+int journal_append(const journal_state_t *state)
+{
+    (void)state;
+
+    return -ENOTSUP;
+}
+
+#endif /* MTD_0 */
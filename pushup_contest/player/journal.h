@@ -0,0 +1,64 @@
+/**
+ * @file
+ * @brief       Journal of the game state in flash
+ *
+ * Every change of the game state is appended as small record to one of two
+ * flash sectors at the end of the MTD device. Records are never rewritten,
+ * the newest valid one is the current state. Once the active sector is full
+ * the state is compacted into the other sector, which is erased first, so
+ * each sector is erased only once every few hundred changes.
+ *
+ * A sector starts with a header holding a generation number, the sector
+ * with the newer generation is the active one. Records are protected by a
+ * checksum, so a record torn by a reset while writing is skipped.
+ *
+ * On native the MTD device is backed by a file (see JOURNAL_FILE in the
+ * Makefile). On boards without MTD_0 the journal does nothing.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Game state kept in the journal
+ */
+typedef struct {
+    uint32_t count;             /**< pushup count */
+    uint8_t color;              /**< led_color_t of the player */
+    uint8_t phase;              /**< game_phase_t */
+} journal_state_t;
+
+/**
+ * @brief   Mounts the journal and restores the last state
+ *
+ * Formats the journal if none is found. Run this exactly once during
+ * startup, before any other journal function.
+ *
+ * @param[out] state    last state written, only valid on success
+ *
+ * @return  0 if a state was restored
+ * @return  -ENOENT if the journal was empty
+ * @return  other negative errno on error
+ */
+int journal_init(journal_state_t *state);
+
+/**
+ * @brief   Appends @p state to the journal, unless it equals the last one
+ *
+ * Must only be called from one thread.
+ *
+ * @return  0 on success, negative errno on error
+ */
+int journal_append(const journal_state_t *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JOURNAL_H */
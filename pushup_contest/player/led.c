@@ -0,0 +1,182 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "container.h"
+#include "event.h"
+#include "event/thread.h"
+#include "irq.h"
+#include "saul_reg.h"
+#include "ztimer.h"
+
+#include "led.h"
+
+#define SAUL_LED_RED_ID         (0)
+#define SAUL_LED_GREEN_ID       (1)
+#define SAUL_LED_BLUE_ID        (2)
+
+#define LED_CHANNELS            (3)
+
+/* SAUL drivers may block or sleep, so the devices are only written by the
+ * event thread, timer callbacks and callers just post _ev_write */
+#define LED_QUEUE               EVENT_PRIO_HIGHEST
+
+/* durations of the pattern steps in ms, even steps on, odd steps off */
+typedef struct {
+    const uint16_t *steps;
+    uint8_t len;
+} led_pattern_t;
+
+static const uint16_t _blink_steps[] = { 200, 200 };
+static const uint16_t _pulse_steps[] = { 100, 100, 100, 700 };
+
+static const led_pattern_t _solid = { NULL, 0 };
+static const led_pattern_t _blink = { _blink_steps, ARRAY_SIZE(_blink_steps) };
+static const led_pattern_t _pulse = { _pulse_steps, ARRAY_SIZE(_pulse_steps) };
+
+static saul_reg_t *_dev[LED_CHANNELS];
+
+/* bit n set if channel n is currently on */
+static uint8_t _shown;
+
+static const led_pattern_t *_pattern = &_solid;
+static led_color_t _color = LED_COLOR_OFF;
+static uint8_t _step;
+static bool _flashing;
+
+static void _pattern_cb(void *arg);
+static void _flash_cb(void *arg);
+static void _on_write(event_t *ev);
+
+static ztimer_t _pattern_timer = { .callback = _pattern_cb };
+static ztimer_t _flash_timer = { .callback = _flash_cb };
+static event_t _ev_write = { .handler = _on_write };
+
+/* only called by the event thread */
+static void _write(uint8_t mask)
+{
+    uint8_t changed = mask ^ _shown;
+
+    for (unsigned i = 0; i < LED_CHANNELS; i++) {
+        if (changed & (1 << i)) {
+            phydat_t data = {
+                .val = { (mask >> i) & 1 }
+            };
+            saul_reg_write(_dev[i], &data);
+        }
+    }
+
+    _shown = mask;
+}
+
+/* channels the current effect wants on, must be called with interrupts
+ * disabled */
+static uint8_t _target(void)
+{
+    assert(_color <= LED_COLOR_BLUE);
+
+    if (_flashing || (_pattern->len && (_step & 1)) || (_color == LED_COLOR_OFF)) {
+        return 0;
+    }
+
+    /* LED_COLOR_RED..BLUE map to channel 0..2 */
+    return 1 << (_color - LED_COLOR_RED);
+}
+
+static void _on_write(event_t *ev)
+{
+    (void)ev;
+
+    unsigned state = irq_disable();
+    uint8_t mask = _target();
+    irq_restore(state);
+
+    _write(mask);
+}
+
+/* posting an event that is still queued does nothing, the event thread
+ * always writes the latest state */
+static void _apply(void)
+{
+    event_post(LED_QUEUE, &_ev_write);
+}
+
+static void _pattern_cb(void *arg)
+{
+    (void)arg;
+
+    _step = (_step + 1) % _pattern->len;
+    ztimer_set(ZTIMER_MSEC, &_pattern_timer, _pattern->steps[_step]);
+    _apply();
+}
+
+static void _flash_cb(void *arg)
+{
+    (void)arg;
+
+    _flashing = false;
+    _apply();
+}
+
+static void _set_effect(const led_pattern_t *pattern, led_color_t color)
+{
+    unsigned state = irq_disable();
+
+    ztimer_remove(ZTIMER_MSEC, &_pattern_timer);
+    ztimer_remove(ZTIMER_MSEC, &_flash_timer);
+
+    _pattern = pattern;
+    _color = color;
+    _step = 0;
+    _flashing = false;
+
+    if (_pattern->len) {
+        ztimer_set(ZTIMER_MSEC, &_pattern_timer, _pattern->steps[0]);
+    }
+    _apply();
+
+    irq_restore(state);
+}
+
+void led_init(void)
+{
+    phydat_t off = {
+        .val = { 0 }
+    };
+
+    _dev[0] = saul_reg_find_nth(SAUL_LED_RED_ID);
+    _dev[1] = saul_reg_find_nth(SAUL_LED_GREEN_ID);
+    _dev[2] = saul_reg_find_nth(SAUL_LED_BLUE_ID);
+
+    for (unsigned i = 0; i < LED_CHANNELS; i++) {
+        saul_reg_write(_dev[i], &off);
+    }
+    _shown = 0;
+}
+
+void led_solid(led_color_t color)
+{
+    _set_effect(&_solid, color);
+}
+
+void led_blink(led_color_t color)
+{
+    _set_effect(&_blink, color);
+}
+
+void led_pulse(led_color_t color)
+{
+    _set_effect(&_pulse, color);
+}
+
+void led_rep_flash(void)
+{
+    unsigned state = irq_disable();
+
+    _flashing = true;
+    ztimer_set(ZTIMER_MSEC, &_flash_timer, CONFIG_LED_FLASH_MS);
+    _apply();
+
+    irq_restore(state);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @brief       RGB status LED of the player
+ *
+ * The LED shows one effect at a time in one color. Timed effects run from
+ * ztimer callbacks, the SAUL devices of the three channels are written by the
+ * highest priority event thread, so LEDs behind a bus driver work as well.
+ * The devices are resolved once at init and only channels that change are
+ * written.
+ */
+
+#ifndef LED_H
+#define LED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Duration the LED is switched off by led_rep_flash() in ms
+ */
+#ifndef CONFIG_LED_FLASH_MS
+#define CONFIG_LED_FLASH_MS     (800U)
+#endif
+
+/**
+ * @brief   Colors the player LED can show, values are used on the wire
+ */
+typedef enum {
+    LED_COLOR_OFF,
+    LED_COLOR_RED,
+    LED_COLOR_GREEN,
+    LED_COLOR_BLUE,
+} led_color_t;
+
+/**
+ * @brief   Resolves the LED devices and switches all channels off
+ *
+ * Run this exactly once during startup, before any other led_* function.
+ */
+void led_init(void);
+
+/**
+ * @brief   Shows @p color permanently
+ */
+void led_solid(led_color_t color);
+
+/**
+ * @brief   Blinks @p color, 200ms on and 200ms off
+ */
+void led_blink(led_color_t color);
+
+/**
+ * @brief   Shows a heartbeat pattern in @p color
+ */
+void led_pulse(led_color_t color);
+
+/**
+ * @brief   Switches the LED off for CONFIG_LED_FLASH_MS, then continues
+ *          with the current effect
+ */
+void led_rep_flash(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LED_H */
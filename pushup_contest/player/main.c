@@ -3,20 +3,28 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "fmt.h"
 #include "net/gcoap.h"
 #include "net/utils.h"
 #include "od.h"
 #include "flash_utils.h"
-#include "saul_reg.h"
-#include "saul.h"
-#include "thread.h"
 #include "net/cord/epsim.h"
 #include "net/cord/common.h"
 #include "net/gnrc/netif.h"
 #include "net/sock/util.h"
 #include "net/ipv6/addr.h"
-#include "xtimer.h"
+#include "random.h"
+#include "ztimer.h"
+
+#include "coap_links.h"
+#include "count_notify.h"
+#include "dlog.h"
+#include "game.h"
+#include "group.h"
+#include "led.h"
+#include "reps.h"
+#include "samples.h"
+#include "stats.h"
+#include "timesync.h"
 
 #define ENABLE_DEBUG 0
 #include "debug.h"
@@ -25,36 +33,26 @@
 #define SAUL_DEVICE_COUNT      (2)
 #endif
 
-#define STARTUP_DELAY       (3U)    /* wait 3s before sending first request*/
+/* the RD is discovered via link-local multicast */
+#define RD_ADDR_MCAST           "[ff02::1]"
 
-#define SAUL_LED_RED_ID (0)
-#define SAUL_LED_GREEN_ID (1)
-#define SAUL_LED_BLUE_ID (2)
-#define SAUL_ACCELEROMETER_NAME ("mma8x5x")
+#define RD_POLL_MS              (20U)       /* interface and response polling */
+#define RD_LINK_CHECK_MS        (1000U)     /* interface check while registered */
+#define RD_BACKOFF_MIN_MS       (250U)      /* first retry after a failure */
+#define RD_BACKOFF_MAX_MS       (30000U)    /* cap of the exponential backoff */
+#define RD_REFRESH_MARGIN_S     (5U)        /* refresh this long before expiry */
 
+/* registration with the RD, see docs/rd_registration_state_machine.puml */
 typedef enum {
-    LED_COLOR_OFF,
-    LED_COLOR_RED,
-    LED_COLOR_GREEN,
-    LED_COLOR_BLUE,
-} led_color_t;
+    RD_STATE_WAIT_NETIF,        /* no usable address on the interface yet */
+    RD_STATE_REGISTER,          /* send the registration now */
+    RD_STATE_WAIT_RESPONSE,     /* registration sent, waiting for the RD */
+    RD_STATE_REGISTERED,        /* registered, refresh before expiry */
+    RD_STATE_BACKOFF,           /* failed, retry after a randomized delay */
+} rd_state_t;
 
-static uint32_t pushup_count = 0;
-static led_color_t player_color = 0;
-static bool reset = false;
-static bool game_finished = false;
-
-static void run_pushup_detection(void);
-void *pushup_detection_thread(void *arg);
-char pushup_detection_thread_stack[THREAD_STACKSIZE_MAIN];
-
-static void run_led_blink(void);
-void *led_blink_thread(void *arg);
-char led_blink_thread_stack[THREAD_STACKSIZE_MAIN];
-
-
-static ssize_t _encode_link(const coap_resource_t *resource, char *buf,
-                            size_t maxlen, coap_link_encoder_ctx_t *context);
+/* resolved once, reused for every registration */
+static sock_udp_ep_t _rd_ep;
 
 static ssize_t _assign_color_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
                                      coap_request_ctx_t *ctx);
@@ -70,107 +68,87 @@ static ssize_t _fake_pushup_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
                                     coap_request_ctx_t *ctx);
 static ssize_t _reset_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
                               coap_request_ctx_t *ctx);
-
-/* CoAP resources. Must be sorted by path (ASCII order). */
-static const coap_resource_t _resources[] = {
-    { "/assign_color", COAP_PUT, _assign_color_handler, NULL },
-    { "/start", COAP_POST, _start_handler, NULL },
-    { "/count", COAP_GET, _count_handler, NULL },
-    { "/set_to_winner", COAP_POST, _set_to_winner_handler, NULL },
-    { "/set_to_looser", COAP_POST, _set_to_looser_handler, NULL },
-    { "/fake_pushup", COAP_POST, _fake_pushup_handler, NULL },
-    { "/reset", COAP_POST, _reset_handler, NULL },
+static ssize_t _stop_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                             coap_request_ctx_t *ctx);
+
+/* Positions in _resources, ASCII order of the paths */
+enum {
+    RES_ASSIGN_COLOR,
+    RES_COUNT,
+    RES_FAKE_PUSHUP,
+    RES_GROUP,
+    RES_REPS,
+    RES_RESET,
+    RES_SAMPLES,
+    RES_SET_TO_LOOSER,
+    RES_SET_TO_WINNER,
+    RES_START,
+    RES_STATS,
+    RES_STOP,
+    RES_TIME,
+    RES_NUMOF
 };
 
-static const char *_link_params[] = {
-    ";rt=\"pushups_player\"",
-    ";rt=\"pushups_player\"",
-    ";ct=0;rt=\"pushups_player\";obs",
-    ";rt=\"pushups_player\"",
-    ";rt=\"pushups_player\"",
-    ";rt=\"pushups_player\"",
-    ";rt=\"pushups_player\"",
+/* Handlers wrapped by stats_timed_handler(), same order as _resources */
+static stats_timing_t _timing[RES_NUMOF] = {
+    [RES_ASSIGN_COLOR] = STATS_TIMING(_assign_color_handler),
+    [RES_COUNT] = STATS_TIMING(_count_handler),
+    [RES_FAKE_PUSHUP] = STATS_TIMING(_fake_pushup_handler),
+    [RES_GROUP] = STATS_TIMING(group_handler),
+    [RES_REPS] = STATS_TIMING(reps_handler),
+    [RES_RESET] = STATS_TIMING(_reset_handler),
+    [RES_SAMPLES] = STATS_TIMING(samples_handler),
+    [RES_SET_TO_LOOSER] = STATS_TIMING(_set_to_looser_handler),
+    [RES_SET_TO_WINNER] = STATS_TIMING(_set_to_winner_handler),
+    [RES_START] = STATS_TIMING(_start_handler),
+    [RES_STATS] = STATS_TIMING(stats_handler),
+    [RES_STOP] = STATS_TIMING(_stop_handler),
+    [RES_TIME] = STATS_TIMING(timesync_handler),
 };
 
-static gcoap_listener_t _listener = {
-    &_resources[0],
-    ARRAY_SIZE(_resources),
-    GCOAP_SOCKET_TYPE_UNDEF,
-    _encode_link,
-    NULL,
-    NULL
+#define RESOURCE(idx, path, methods) \
+    [idx] = { path, methods, stats_timed_handler, &_timing[idx] }
+
+/* CoAP resources. Must be sorted by path (ASCII order), checked by
+ * coap_links_init() */
+static const coap_resource_t _resources[RES_NUMOF] = {
+    RESOURCE(RES_ASSIGN_COLOR, "/assign_color", COAP_PUT),
+    RESOURCE(RES_COUNT, "/count", COAP_GET),
+    RESOURCE(RES_FAKE_PUSHUP, "/fake_pushup", COAP_POST),
+    RESOURCE(RES_GROUP, "/group", COAP_GET | COAP_POST),
+    RESOURCE(RES_REPS, "/reps", COAP_GET),
+    RESOURCE(RES_RESET, "/reset", COAP_POST),
+    RESOURCE(RES_SAMPLES, "/samples", COAP_GET),
+    RESOURCE(RES_SET_TO_LOOSER, "/set_to_looser", COAP_POST),
+    RESOURCE(RES_SET_TO_WINNER, "/set_to_winner", COAP_POST),
+    RESOURCE(RES_START, "/start", COAP_POST),
+    RESOURCE(RES_STATS, "/stats", COAP_GET),
+    RESOURCE(RES_STOP, "/stop", COAP_POST),
+    RESOURCE(RES_TIME, "/time", COAP_GET | COAP_PUT),
 };
 
-/* Adds link format params to resource list */
-static ssize_t _encode_link(const coap_resource_t *resource, char *buf,
-                            size_t maxlen, coap_link_encoder_ctx_t *context)
-{
-    ssize_t res = gcoap_encode_link(resource, buf, maxlen, context);
-
-    if (res > 0) {
-        if (_link_params[context->link_pos]
-            && (strlen(_link_params[context->link_pos]) < (maxlen - res))) {
-            if (buf) {
-                memcpy(buf + res, _link_params[context->link_pos],
-                       strlen(_link_params[context->link_pos]));
-            }
-            return res + strlen(_link_params[context->link_pos]);
-        }
-    }
-
-    return res;
-}
+static const char *const _link_params[RES_NUMOF] = {
+    [RES_ASSIGN_COLOR] = ";rt=\"pushups_player\"",
+    [RES_COUNT] = ";ct=0;rt=\"pushups_player\";obs",
+    [RES_FAKE_PUSHUP] = ";rt=\"pushups_player\"",
+    [RES_GROUP] = ";ct=0;rt=\"pushups_group\"",
+    [RES_REPS] = ";ct=60;rt=\"pushups_reps\"",
+    [RES_RESET] = ";rt=\"pushups_player\"",
+    [RES_SAMPLES] = ";ct=42;rt=\"pushups_samples\";obs",
+    [RES_SET_TO_LOOSER] = ";rt=\"pushups_player\"",
+    [RES_SET_TO_WINNER] = ";rt=\"pushups_player\"",
+    [RES_START] = ";rt=\"pushups_player\"",
+    [RES_STATS] = ";ct=60;rt=\"pushups_stats\";obs",
+    [RES_STOP] = ";rt=\"pushups_player\"",
+    [RES_TIME] = ";ct=0;rt=\"pushups_time\"",
+};
 
-void notify_count_observers(void)
-{
-    size_t len;
-    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
-    coap_pkt_t pdu;
-
-    /* send Observe notification for /count */
-    switch (gcoap_obs_init(&pdu, &buf[0], CONFIG_GCOAP_PDU_BUF_SIZE,
-                           &_resources[2])) {
-    case GCOAP_OBS_INIT_OK:
-        printf("Creating /count notification\n");
-        coap_opt_add_format(&pdu, COAP_FORMAT_TEXT);
-        len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
-        len += fmt_u32_dec((char *)pdu.payload, pushup_count);
-        gcoap_obs_send(&buf[0], len, &_resources[2]);
-        break;
-    case GCOAP_OBS_INIT_UNUSED:
-        printf("No observer for /count\n");
-        break;
-    case GCOAP_OBS_INIT_ERR:
-        printf("Error initializing /count notification\n");
-        break;
-    }
-}
+/* resources with their link format, served on /.well-known/core */
+static coap_links_t _links;
 
-static void set_led_color(led_color_t color)
+static void notify_samples_observers(void)
 {
-    saul_reg_t *red = saul_reg_find_nth(SAUL_LED_RED_ID);
-    saul_reg_t *green = saul_reg_find_nth(SAUL_LED_GREEN_ID);
-    saul_reg_t *blue = saul_reg_find_nth(SAUL_LED_BLUE_ID);
-
-    phydat_t off = {
-        .val = { 0 }
-    };
-    phydat_t on = {
-        .val = { 1 }
-    };
-
-    /* turn all off first */
-    saul_reg_write(red, &off);
-    saul_reg_write(green, &off);
-    saul_reg_write(blue, &off);
-
-    /* turn on the required led color */
-    switch (color) {
-    case LED_COLOR_OFF: break;
-    case LED_COLOR_RED: saul_reg_write(red, &on); break;
-    case LED_COLOR_GREEN: saul_reg_write(green, &on); break;
-    case LED_COLOR_BLUE: saul_reg_write(blue, &on); break;
-    }
+    samples_notify(&_resources[RES_SAMPLES]);
 }
 
 static ssize_t _assign_color_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
@@ -180,10 +158,16 @@ static ssize_t _assign_color_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 
     printf("COAP: Set Color\n");
 
-    printf("PLAYER COLOR: %d\n", atoi((char *)pdu->payload));
+    /* the payload is not terminated, a single digit is all there is */
+    if ((pdu->payload_len != 1) || (pdu->payload[0] < '0' + LED_COLOR_OFF)
+        || (pdu->payload[0] > '0' + LED_COLOR_BLUE)) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+    }
+    led_color_t color = (led_color_t)(pdu->payload[0] - '0');
+
+    printf("PLAYER COLOR: %d\n", color);
 
-    player_color = (led_color_t)atoi((char *)pdu->payload);
-    set_led_color(player_color);
+    game_assign_color(color);
 
     return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
 }
@@ -195,13 +179,7 @@ static ssize_t _start_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 
     printf("COAP: Start\n");
 
-    reset = false;
-    game_finished = false;
-
-    /* run pushup detection in its own thread */
-    thread_create(pushup_detection_thread_stack, sizeof(pushup_detection_thread_stack),
-                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
-                  pushup_detection_thread, NULL, "pushup_detection_thread");
+    game_start();
 
     return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
 }
@@ -216,8 +194,8 @@ static ssize_t _count_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
     coap_opt_add_format(pdu, COAP_FORMAT_TEXT);
     size_t resp_len = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
 
-    /* write the response buffer with the request count value */
-    resp_len += fmt_u32_dec((char *)pdu->payload, pushup_count);
+    /* same payload as the notifications */
+    resp_len += count_notify_payload((char *)pdu->payload);
     return resp_len;
 }
 
@@ -228,12 +206,7 @@ static ssize_t _set_to_winner_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 
     printf("COAP: Set to winner\n");
 
-    /* run led blinking in its own thread */
-    thread_create(led_blink_thread_stack, sizeof(led_blink_thread_stack),
-                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
-                  led_blink_thread, NULL, "led_blink_thread");
-
-    game_finished = true;
+    game_win();
 
     return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
 }
@@ -244,9 +217,8 @@ static ssize_t _set_to_looser_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
     (void)ctx;
 
     printf("COAP: Set to looser\n");
-    set_led_color(LED_COLOR_OFF);
 
-    game_finished = true;
+    game_lose();
 
     return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
 }
@@ -258,14 +230,7 @@ static ssize_t _fake_pushup_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 
     printf("COAP: Fake pushup\n");
 
-    set_led_color(LED_COLOR_OFF);
-
-    xtimer_msleep(1000);
-
-    set_led_color(LED_COLOR_BLUE);
-
-    pushup_count++;
-    notify_count_observers();
+    game_add_rep();
 
     return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
 }
@@ -275,117 +240,136 @@ static ssize_t _reset_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 {
     (void)ctx;
 
-    reset = true;
-    pushup_count = 0;
-    set_led_color(player_color);
+    printf("COAP: Reset\n");
 
-    notify_count_observers();
+    game_reset();
 
     return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
 }
 
-void *led_blink_thread(void *arg)
+static ssize_t _stop_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                             coap_request_ctx_t *ctx)
 {
-    printf("Started pushup detection thread\n");
-    (void)arg;
-
-    run_led_blink();
-
-    return NULL;
-}
+    (void)ctx;
 
-static void run_led_blink(void)
-{
-    printf("Started led blinking\n");
+    printf("COAP: Stop\n");
 
-    while (!reset) {
-        set_led_color(LED_COLOR_OFF);
-        xtimer_msleep(200);
-        set_led_color(player_color);
-        xtimer_msleep(200);
-    }
+    game_stop();
 
-    printf("LED_BLINK_THREAD_YIELDS\n");
-    thread_yield();
+    return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
 }
 
-void *pushup_detection_thread(void *arg)
+static bool _netif_ready(const gnrc_netif_t *netif)
 {
-    printf("Started pushup detection thread\n");
-    (void)arg;
+    ipv6_addr_t addrs[CONFIG_GNRC_NETIF_IPV6_ADDRS_NUMOF];
 
-    run_pushup_detection();
-
-    return NULL;
+    return gnrc_netif_ipv6_addrs_get(netif, addrs, sizeof(addrs)) > 0;
 }
 
-static void run_pushup_detection(void)
+static int _rd_resolve(void)
 {
-    printf("Started pushup detection\n");
-    saul_reg_t *dev = saul_reg_find_name(SAUL_ACCELEROMETER_NAME);
+    if (sock_udp_name2ep(&_rd_ep, RD_ADDR_MCAST) < 0) {
+        puts("error: unable to parse RD address");
+        return -1;
+    }
 
-    int *data_storage = malloc(sizeof(int) * 1000);
+    /* if netif is not specified in addr and it's link local */
+    if ((_rd_ep.netif == SOCK_ADDR_ANY_NETIF) &&
+        ipv6_addr_is_link_local((ipv6_addr_t *)&_rd_ep.addr.ipv6)) {
+        /* if there is only one interface we use that */
+        if (gnrc_netif_numof() == 1) {
+            _rd_ep.netif = (uint16_t)gnrc_netif_iter(NULL)->pid;
+        }
+        /* if there are many it's an error */
+        else {
+            puts("error: must specify an interface for a link local address");
+            return -1;
+        }
+    }
 
-    int sum = 0;
-    int cnt = 0;
-    bool down_detected = false;
+    if (_rd_ep.port == 0) {
+        _rd_ep.port = COAP_PORT;
+    }
 
-    set_led_color(player_color);
-    phydat_t res;
-    saul_reg_read(dev, &res);
+    return 0;
+}
 
-    int start_value = res.val[2];
+/* never returns, keeps the player registered with the RD */
+static void _rd_run(void)
+{
+    const gnrc_netif_t *netif = gnrc_netif_get_by_pid(_rd_ep.netif);
+    rd_state_t state = RD_STATE_WAIT_NETIF;
+    uint32_t backoff = RD_BACKOFF_MIN_MS;
+    uint32_t refresh_at = 0;
+    uint32_t refresh_ms = (CONFIG_CORD_LT > 2 * RD_REFRESH_MARGIN_S)
+                          ? (CONFIG_CORD_LT - RD_REFRESH_MARGIN_S) * 1000U
+                          : (CONFIG_CORD_LT * 1000U) / 2;
 
-    while (!reset && !game_finished) {
-        for (int i = 0; i < 150; i++) {
-            if (reset || game_finished) {
+    while (1) {
+        switch (state) {
+        case RD_STATE_WAIT_NETIF:
+            if ((netif != NULL) && !_netif_ready(netif)) {
+                ztimer_sleep(ZTIMER_MSEC, RD_POLL_MS);
                 break;
             }
+            state = RD_STATE_REGISTER;
+            break;
 
-            saul_reg_read(dev, &res);
-
-            // data_storage[0][i] = res.val[0];
-            // data_storage[1][i] = res.val[1];
-            data_storage[i] = res.val[2];
-
-            printf("%d\n", res.val[2] - start_value);
-            sum += (res.val[2] - start_value);
-            cnt++;
-
+        case RD_STATE_REGISTER:
+            if (cord_epsim_register(&_rd_ep) == CORD_EPSIM_ERROR) {
+                puts("error: unable to trigger simple registration process");
+                state = RD_STATE_BACKOFF;
+                break;
+            }
+            state = RD_STATE_WAIT_RESPONSE;
+            break;
 
-            if (sum < -250) {
-                printf("\ndown\n");
-                sum = 0;
-                down_detected = true;
+        case RD_STATE_WAIT_RESPONSE:
+            switch (cord_epsim_state()) {
+            case CORD_EPSIM_BUSY:
+                ztimer_sleep(ZTIMER_MSEC, RD_POLL_MS);
+                break;
+            case CORD_EPSIM_OK:
+                puts("state: registration active");
+                backoff = RD_BACKOFF_MIN_MS;
+                refresh_at = ztimer_now(ZTIMER_MSEC) + refresh_ms;
+                state = RD_STATE_REGISTERED;
+                break;
+            case CORD_EPSIM_ERROR:
+            default:
+                puts("state: not registered");
+                state = RD_STATE_BACKOFF;
+                break;
             }
-            else if (sum > 250) {
-                printf("\nup\n");
-                sum = 0;
-                if (down_detected) {
-                    printf("\n****Repetition****\n\n");
-                    down_detected = false;
-                    set_led_color(LED_COLOR_OFF);
-                    cnt = 0;
-
-                    /* update pushups counter and notify observers */
-                    pushup_count++;
-                    notify_count_observers();
-                }
+            break;
+
+        case RD_STATE_REGISTERED: {
+            /* a node that lost its address registers again as soon as the
+             * interface is back instead of waiting for the refresh */
+            if ((netif != NULL) && !_netif_ready(netif)) {
+                puts("state: interface down");
+                state = RD_STATE_WAIT_NETIF;
+                break;
             }
-            if (cnt == 4) {
-                cnt = 0;
-                sum = 0;
-                set_led_color(player_color);
+
+            int32_t remaining = (int32_t)(refresh_at - ztimer_now(ZTIMER_MSEC));
+            if (remaining <= 0) {
+                state = RD_STATE_REGISTER;
+                break;
             }
+            ztimer_sleep(ZTIMER_MSEC, ((uint32_t)remaining < RD_LINK_CHECK_MS)
+                                      ? (uint32_t)remaining : RD_LINK_CHECK_MS);
+            break;
+        }
 
-            xtimer_msleep(200);
+        case RD_STATE_BACKOFF:
+            /* jitter keeps nodes that failed together from retrying together */
+            ztimer_sleep(ZTIMER_MSEC, random_uint32_range(backoff / 2, backoff + 1));
+            backoff = (backoff < RD_BACKOFF_MAX_MS / 2) ? backoff * 2 : RD_BACKOFF_MAX_MS;
+            state = RD_STATE_WAIT_NETIF;
+            break;
         }
-        free(data_storage);
-        printf("\n");
     }
-
-    printf("PUSHUP_DETECTION_THREAD_YIELDS\n");
-    thread_yield();
 }
 
 int main(void)
@@ -393,72 +377,46 @@ int main(void)
     char ep_str[CONFIG_SOCK_URLPATH_MAXLEN];
     uint16_t ep_port;
 
-    set_led_color(LED_COLOR_BLUE);
+    led_init();
+    led_solid(LED_COLOR_BLUE);
 
     puts("Simplified CoRE RD registration example\n");
 
-    /* parse RD address information */
-    sock_udp_ep_t rd_ep;
-
-    if (sock_udp_name2ep(&rd_ep, "[ff02::1]") < 0) {
-        puts("error: unable to parse RD address from RD_ADDR variable");
+    /* everything that can fail is checked before any thread is started, a
+     * player counting without being reachable would be worse than none */
+    if (_rd_resolve() < 0) {
         return -1;
     }
 
-    /* if netif is not specified in addr and it's link local */
-    if ((rd_ep.netif == SOCK_ADDR_ANY_NETIF) &&
-        ipv6_addr_is_link_local((ipv6_addr_t *)&rd_ep.addr.ipv6)) {
-        /* if there is only one interface we use that */
-        if (gnrc_netif_numof() == 1) {
-            rd_ep.netif = (uint16_t)gnrc_netif_iter(NULL)->pid;
-        }
-        /* if there are many it's an error */
-        else {
-            puts("error: must specify an interface for a link local address");
-            return -1;
-        }
+    if (coap_links_init(&_links, _resources, ARRAY_SIZE(_resources), _link_params) < 0) {
+        return -1;
     }
-
-    if (rd_ep.port == 0) {
-        rd_ep.port = COAP_PORT;
+    /* the RD fetches /.well-known/core after the simple registration, a
+     * player missing links there cannot be controlled by the referee */
+    if (coap_links_len(&_links) > COAP_LINKS_PDU_ROOM) {
+        puts("error: CONFIG_GCOAP_PDU_BUF_SIZE too small for the link format");
+        return -1;
     }
 
-    sock_udp_ep_fmt(&rd_ep, ep_str, &ep_port);
+    dlog_init();
+    count_notify_init(&_resources[RES_COUNT]);
+    game_init(count_notify_update, notify_samples_observers);
+
+    sock_udp_ep_fmt(&_rd_ep, ep_str, &ep_port);
+
+    if (group_init(gnrc_netif_get_by_pid(_rd_ep.netif)) < 0) {
+        puts("warning: unable to join the player group");
+    }
 
     /* register resource handlers with gcoap */
-    gcoap_register_listener(&_listener);
+    gcoap_register_listener(&_links.listener);
+    stats_init(&_links.listener, &_resources[RES_STATS]);
 
     /* print RD client information */
     puts("epsim configuration:");
     printf(" RD address: [%s]:%u\n\n", ep_str, ep_port);
 
-    xtimer_sleep(STARTUP_DELAY);
-
-    while (1) {
-        int res = cord_epsim_state();
-        switch (res) {
-        case CORD_EPSIM_OK:
-            puts("state: registration active");
-            break;
-        case CORD_EPSIM_BUSY:
-            puts("state: registration in progress");
-            break;
-        case CORD_EPSIM_ERROR:
-        default:
-            puts("state: not registered");
-            break;
-        }
-
-        printf("updating registration with RD [%s]:%u\n", ep_str, ep_port);
-        res = cord_epsim_register(&rd_ep);
-        if (res == CORD_EPSIM_BUSY) {
-            puts("warning: registration already in progress");
-        }
-        else if (res == CORD_EPSIM_ERROR) {
-            puts("error: unable to trigger simple registration process");
-        }
-        xtimer_sleep(CONFIG_CORD_UPDATE_INTERVAL);
-    }
+    _rd_run();
 
     return 0;
 }
@@ -0,0 +1,195 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "irq.h"
+#include "nanocbor/nanocbor.h"
+#include "net/gcoap.h"
+
+#include "reps.h"
+#include "timesync.h"
+
+/* upper bound of one encoded record: array header, uint64 and three uint32 */
+#define REPS_RECORD_MAX_LEN     (1 + 9 + 3 * 5)
+
+enum {
+    REPS_KEY_COUNT,
+    REPS_KEY_MEAN,
+    REPS_KEY_VARIANCE,
+    REPS_KEY_FASTEST,
+    REPS_KEY_SLOWEST,
+    REPS_KEY_DEPTH,
+    REPS_KEY_FIRST,
+    REPS_KEY_REPS,
+    REPS_KEY_NUMOF,
+};
+
+typedef struct {
+    uint64_t start;             /* us, see timesync_now() */
+    uint16_t bottom;            /* ms after start */
+    uint16_t end;               /* ms after start */
+    uint16_t depth;             /* mg */
+} _record_t;
+
+typedef struct {
+    uint32_t count;
+    uint64_t sum;
+    uint64_t sq_sum;
+    uint32_t fastest;
+    uint32_t slowest;
+    uint64_t depth_sum;
+} _stats_t;
+
+/* written by the game thread, read by the gcoap thread */
+static _record_t _log[CONFIG_REPS_LOG_SIZE];
+static _stats_t _stats;
+
+static uint16_t _offset_ms(uint32_t from_us, uint32_t to_us)
+{
+    uint32_t ms = (to_us - from_us) / 1000U;
+
+    return (ms > UINT16_MAX) ? UINT16_MAX : ms;
+}
+
+void reps_add(const detector_rep_t *rep)
+{
+    _record_t record = {
+        .start = timesync_from_usec(rep->start),
+        .bottom = _offset_ms(rep->start, rep->bottom),
+        .end = _offset_ms(rep->start, rep->end),
+        .depth = rep->depth,
+    };
+    uint32_t duration = record.end;
+
+    unsigned state = irq_disable();
+
+    _log[_stats.count % CONFIG_REPS_LOG_SIZE] = record;
+
+    if ((_stats.count == 0) || (duration < _stats.fastest)) {
+        _stats.fastest = duration;
+    }
+    if (duration > _stats.slowest) {
+        _stats.slowest = duration;
+    }
+    _stats.count++;
+    _stats.sum += duration;
+    _stats.sq_sum += (uint64_t)duration * duration;
+    _stats.depth_sum += record.depth;
+
+    irq_restore(state);
+}
+
+void reps_reset(void)
+{
+    unsigned state = irq_disable();
+
+    memset(&_stats, 0, sizeof(_stats));
+
+    irq_restore(state);
+}
+
+static void _encode_stats(nanocbor_encoder_t *enc, const _stats_t *stats)
+{
+    uint64_t n = stats->count;
+    uint64_t mean = 0;
+    uint64_t variance = 0;
+
+    if (n > 0) {
+        mean = stats->sum / n;
+        /* n * sum(x^2) - sum(x)^2 is exact, subtracting squared means is not */
+        variance = (n * stats->sq_sum - stats->sum * stats->sum) / (n * n);
+    }
+
+    nanocbor_fmt_uint(enc, REPS_KEY_COUNT);
+    nanocbor_fmt_uint(enc, n);
+    nanocbor_fmt_uint(enc, REPS_KEY_MEAN);
+    nanocbor_fmt_uint(enc, mean);
+    nanocbor_fmt_uint(enc, REPS_KEY_VARIANCE);
+    nanocbor_fmt_uint(enc, variance);
+    nanocbor_fmt_uint(enc, REPS_KEY_FASTEST);
+    nanocbor_fmt_uint(enc, stats->fastest);
+    nanocbor_fmt_uint(enc, REPS_KEY_SLOWEST);
+    nanocbor_fmt_uint(enc, stats->slowest);
+    nanocbor_fmt_uint(enc, REPS_KEY_DEPTH);
+    nanocbor_fmt_uint(enc, n ? stats->depth_sum / n : 0);
+}
+
+ssize_t reps_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                     coap_request_ctx_t *ctx)
+{
+    (void)ctx;
+
+    _record_t records[CONFIG_REPS_PAGE];
+    _stats_t stats;
+    uint32_t first;
+    uint32_t cnt;
+
+    const char *since;
+    size_t since_len;
+    bool has_since = coap_find_uri_query(pdu, "since", &since, &since_len);
+    uint32_t since_num = has_since ? scn_u32_dec(since, since_len) : 0;
+
+    unsigned state = irq_disable();
+
+    stats = _stats;
+
+    uint32_t oldest = (stats.count > CONFIG_REPS_LOG_SIZE)
+                      ? stats.count - CONFIG_REPS_LOG_SIZE : 0;
+
+    if (!has_since) {
+        first = (stats.count > CONFIG_REPS_PAGE)
+                ? stats.count - CONFIG_REPS_PAGE : 0;
+    }
+    else {
+        first = (since_num > stats.count) ? stats.count : since_num;
+    }
+    if (first < oldest) {
+        first = oldest;
+    }
+
+    cnt = stats.count - first;
+    if (cnt > CONFIG_REPS_PAGE) {
+        cnt = CONFIG_REPS_PAGE;
+    }
+    for (uint32_t i = 0; i < cnt; i++) {
+        records[i] = _log[(first + i) % CONFIG_REPS_LOG_SIZE];
+    }
+
+    irq_restore(state);
+
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_CBOR);
+    size_t resp_len = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, pdu->payload, pdu->payload_len);
+    nanocbor_fmt_map(&enc, REPS_KEY_NUMOF);
+    _encode_stats(&enc, &stats);
+    nanocbor_fmt_uint(&enc, REPS_KEY_FIRST);
+    nanocbor_fmt_uint(&enc, first);
+    nanocbor_fmt_uint(&enc, REPS_KEY_REPS);
+    nanocbor_fmt_array_indefinite(&enc);
+
+    /* the client asks again with since for whatever did not fit */
+    for (uint32_t i = 0; i < cnt; i++) {
+        if (nanocbor_encoded_len(&enc) + REPS_RECORD_MAX_LEN + 1
+            > pdu->payload_len) {
+            break;
+        }
+        nanocbor_fmt_array(&enc, 4);
+        nanocbor_fmt_uint(&enc, records[i].start);
+        nanocbor_fmt_uint(&enc, records[i].bottom);
+        nanocbor_fmt_uint(&enc, records[i].end);
+        nanocbor_fmt_uint(&enc, records[i].depth);
+    }
+
+    nanocbor_fmt_end_indefinite(&enc);
+
+    if (nanocbor_encoded_len(&enc) > pdu->payload_len) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_INTERNAL_SERVER_ERROR);
+    }
+
+    return resp_len + nanocbor_encoded_len(&enc);
+}
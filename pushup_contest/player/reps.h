@@ -0,0 +1,74 @@
+/**
+ * @file
+ * @brief       Log of the detected repetitions and /reps resource
+ *
+ * The last CONFIG_REPS_LOG_SIZE repetitions are kept with their timing.
+ * Statistics over all repetitions since the last reset are updated with
+ * every repetition in constant time.
+ *
+ * The payload of /reps is a CBOR map (application/cbor) with small integer
+ * keys, times are in ms:
+ *
+ *      0: number of repetitions
+ *      1: mean rep time (down to up)
+ *      2: variance of the rep time in ms^2
+ *      3: fastest rep time
+ *      4: slowest rep time
+ *      5: mean depth in mg, an estimate of the range of motion
+ *      6: number of the first repetition in 7, counting from 0
+ *      7: array of [start, bottom - start, end - start, depth] per repetition,
+ *         start in us in the timebase of timesync_now()
+ *
+ * GET returns the latest repetitions that fit, `?since=<n>` the repetitions
+ * from number n on. Repetitions already dropped from the log are skipped.
+ */
+
+#ifndef REPS_H
+#define REPS_H
+
+#include <stdint.h>
+
+#include "detector.h"
+#include "net/gcoap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Number of repetitions kept in the log
+ */
+#ifndef CONFIG_REPS_LOG_SIZE
+#define CONFIG_REPS_LOG_SIZE    (64U)
+#endif
+
+/**
+ * @brief   Maximum number of repetitions returned at once
+ */
+#ifndef CONFIG_REPS_PAGE
+#define CONFIG_REPS_PAGE        (8U)
+#endif
+
+/**
+ * @brief   Logs a repetition and updates the statistics
+ *
+ * @param[in] rep   repetition as reported by the detector
+ */
+void reps_add(const detector_rep_t *rep);
+
+/**
+ * @brief   Clears the log and the statistics
+ */
+void reps_reset(void);
+
+/**
+ * @brief   CoAP handler of the /reps resource
+ */
+ssize_t reps_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                     coap_request_ctx_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REPS_H */
@@ -0,0 +1,199 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "saul_reg.h"
+#include "thread.h"
+#include "thread_flags.h"
+#include "ztimer.h"
+#include "ztimer/periodic.h"
+
+#include "sampler.h"
+#include "stats.h"
+
+#define ENABLE_DEBUG 0
+#include "debug.h"
+
+#define SAMPLER_BUF_MASK        (CONFIG_SAMPLER_BUF_SIZE - 1)
+#define SAMPLER_PERIOD_MS       (1000U / CONFIG_SAMPLER_RATE_HZ)
+
+#define SAMPLER_FLAG_TICK       (0x0001)
+
+static_assert((CONFIG_SAMPLER_BUF_SIZE & SAMPLER_BUF_MASK) == 0,
+              "CONFIG_SAMPLER_BUF_SIZE must be a power of two");
+
+static char _stack[THREAD_STACKSIZE_DEFAULT];
+static kernel_pid_t _pid = KERNEL_PID_UNDEF;
+static saul_reg_t *_dev;
+static ztimer_periodic_t _timer;
+
+static volatile kernel_pid_t _consumer = KERNEL_PID_UNDEF;
+static volatile bool _running;
+
+/* single producer (sampler thread) / single consumer ring buffer: _head is
+ * only written by the producer, _tail only by the consumer */
+static accel_sample_t _buf[CONFIG_SAMPLER_BUF_SIZE];
+static atomic_uint _head;
+static atomic_uint _tail;
+static atomic_uint _dropped;
+
+static bool _push(const accel_sample_t *sample)
+{
+    unsigned head = atomic_load_explicit(&_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&_tail, memory_order_acquire);
+
+    if (head - tail == CONFIG_SAMPLER_BUF_SIZE) {
+        return false;
+    }
+
+    _buf[head & SAMPLER_BUF_MASK] = *sample;
+    atomic_store_explicit(&_head, head + 1, memory_order_release);
+
+    return true;
+}
+
+bool sampler_pop(accel_sample_t *sample)
+{
+    unsigned tail = atomic_load_explicit(&_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&_head, memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+
+    *sample = _buf[tail & SAMPLER_BUF_MASK];
+    atomic_store_explicit(&_tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+uint32_t sampler_seq(void)
+{
+    return atomic_load_explicit(&_head, memory_order_acquire);
+}
+
+uint32_t sampler_history_start(void)
+{
+    uint32_t head = sampler_seq();
+
+    return (head > CONFIG_SAMPLER_BUF_SIZE - SAMPLER_HISTORY_MARGIN)
+           ? head - (CONFIG_SAMPLER_BUF_SIZE - SAMPLER_HISTORY_MARGIN) : 0;
+}
+
+const accel_sample_t *sampler_history(uint32_t seq)
+{
+    uint32_t head = sampler_seq();
+
+    if ((uint32_t)(head - seq - 1) >= CONFIG_SAMPLER_BUF_SIZE - SAMPLER_HISTORY_MARGIN) {
+        return NULL;
+    }
+
+    return &_buf[seq & SAMPLER_BUF_MASK];
+}
+
+bool sampler_history_valid(uint32_t seq)
+{
+    /* the producer only writes the slot of seq once head reached
+     * seq + CONFIG_SAMPLER_BUF_SIZE */
+    return (uint32_t)(sampler_seq() - seq) < CONFIG_SAMPLER_BUF_SIZE;
+}
+
+uint32_t sampler_dropped(void)
+{
+    return atomic_load_explicit(&_dropped, memory_order_relaxed);
+}
+
+/* runs in interrupt context, the actual (possibly I2C) read is done by the
+ * sampler thread */
+static bool _tick(void *arg)
+{
+    (void)arg;
+
+    thread_flags_set(thread_get(_pid), SAMPLER_FLAG_TICK);
+
+    return ZTIMER_PERIODIC_KEEP_GOING;
+}
+
+static void *_sampler_thread(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        thread_flags_wait_any(SAMPLER_FLAG_TICK);
+
+        if (!_running) {
+            continue;
+        }
+
+        phydat_t res;
+        accel_sample_t sample;
+
+        sample.time = ztimer_now(ZTIMER_USEC);
+        if (saul_reg_read(_dev, &res) < 3) {
+            DEBUG("sampler: unable to read accelerometer\n");
+            continue;
+        }
+        sample.acc[0] = res.val[0];
+        sample.acc[1] = res.val[1];
+        sample.acc[2] = res.val[2];
+
+        if (!_push(&sample)) {
+            atomic_fetch_add_explicit(&_dropped, 1, memory_order_relaxed);
+            continue;
+        }
+
+        kernel_pid_t consumer = _consumer;
+        if (consumer != KERNEL_PID_UNDEF) {
+            thread_flags_set(thread_get(consumer), SAMPLER_FLAG_DATA);
+        }
+    }
+
+    return NULL;
+}
+
+int sampler_init(saul_reg_t *dev)
+{
+    if (dev == NULL) {
+        puts("sampler: no accelerometer found");
+        return -1;
+    }
+
+    _dev = dev;
+    ztimer_periodic_init(ZTIMER_MSEC, &_timer, _tick, NULL, SAMPLER_PERIOD_MS);
+
+    _pid = thread_create(_stack, sizeof(_stack), THREAD_PRIORITY_MAIN - 2,
+                         THREAD_CREATE_STACKTEST, _sampler_thread, NULL,
+                         "sampler");
+
+    if (_pid <= 0) {
+        _pid = KERNEL_PID_UNDEF;
+        return -1;
+    }
+    stats_watch_stack(_pid);
+
+    return 0;
+}
+
+void sampler_start(kernel_pid_t consumer)
+{
+    if (_pid == KERNEL_PID_UNDEF) {
+        return;
+    }
+
+    /* called by the consumer itself while the producer is idle, so it may
+     * discard whatever is left in the buffer */
+    atomic_store_explicit(&_tail, atomic_load(&_head), memory_order_release);
+
+    _consumer = consumer;
+    _running = true;
+    ztimer_periodic_start(&_timer);
+}
+
+void sampler_stop(void)
+{
+    ztimer_periodic_stop(&_timer);
+    _running = false;
+    _consumer = KERNEL_PID_UNDEF;
+}
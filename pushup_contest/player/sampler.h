@@ -0,0 +1,124 @@
+/**
+ * @file
+ * @brief       Fixed-rate accelerometer sampler
+ *
+ * A dedicated thread reads the accelerometer on every tick of a periodic
+ * ztimer and pushes timestamped samples into a static single-producer /
+ * single-consumer ring buffer. The consumer is woken with a thread flag and
+ * drains the buffer with sampler_pop().
+ */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "accel_sample.h"
+#include "saul_reg.h"
+#include "sched.h"
+#include "thread_flags.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Sampling rate of the accelerometer in Hz
+ */
+#ifndef CONFIG_SAMPLER_RATE_HZ
+#define CONFIG_SAMPLER_RATE_HZ      (50U)
+#endif
+
+/**
+ * @brief   Number of samples the ring buffer can hold, must be a power of two
+ *
+ * Samples already consumed stay readable as history until overwritten.
+ */
+#ifndef CONFIG_SAMPLER_BUF_SIZE
+#define CONFIG_SAMPLER_BUF_SIZE     (128U)
+#endif
+
+/**
+ * @brief   Slots at the write end of the buffer not handed out as history
+ *
+ * Gives readers of the history time to read a sample before the sampler
+ * can overwrite it.
+ */
+#define SAMPLER_HISTORY_MARGIN      (4U)
+
+/**
+ * @brief   Thread flag set on the consumer whenever a new sample is available
+ *
+ * Does not collide with THREAD_FLAG_EVENT, so the consumer may also wait on
+ * an event queue.
+ */
+#define SAMPLER_FLAG_DATA           (0x0002)
+
+/**
+ * @brief   Creates the sampler thread for the given accelerometer
+ *
+ * Run this exactly once during startup.
+ *
+ * @return  0 on success, negative on error
+ */
+int sampler_init(saul_reg_t *dev);
+
+/**
+ * @brief   Empties the buffer and starts sampling
+ *
+ * @param[in] consumer  pid of the thread that gets SAMPLER_FLAG_DATA
+ */
+void sampler_start(kernel_pid_t consumer);
+
+/**
+ * @brief   Stops sampling, samples already buffered stay available
+ */
+void sampler_stop(void);
+
+/**
+ * @brief   Takes the oldest sample out of the buffer
+ *
+ * Must only be called from the consumer thread.
+ *
+ * @return  true if @p sample was filled, false if the buffer was empty
+ */
+bool sampler_pop(accel_sample_t *sample);
+
+/**
+ * @brief   Sequence number the next sample will get
+ *
+ * Every sample gets a sequence number, counting up from boot and wrapping.
+ */
+uint32_t sampler_seq(void);
+
+/**
+ * @brief   Oldest sequence number available as history
+ */
+uint32_t sampler_history_start(void);
+
+/**
+ * @brief   Direct access to a sample in the buffer
+ *
+ * Lock-free: the sample is not copied, so after reading it the caller must
+ * check with sampler_history_valid() that it was not overwritten meanwhile.
+ *
+ * @return  the sample with sequence number @p seq, NULL if not available
+ */
+const accel_sample_t *sampler_history(uint32_t seq);
+
+/**
+ * @brief   Checks that the samples from @p seq on were not overwritten
+ */
+bool sampler_history_valid(uint32_t seq);
+
+/**
+ * @brief   Number of samples dropped because the buffer was full
+ */
+uint32_t sampler_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLER_H */
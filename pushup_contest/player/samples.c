@@ -0,0 +1,196 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "net/gcoap.h"
+
+#include "sampler.h"
+#include "samples.h"
+
+#define ENABLE_DEBUG 0
+#include "debug.h"
+
+#define SAMPLES_HDR_LEN         (8U)
+#define SAMPLES_RECORD_LEN      (8U)
+#define SAMPLES_DT_UNIT_US      (100U)
+
+/* the axes are copied from the sample buffer as they are */
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "/samples encoding assumes a little endian CPU");
+
+/* next sample to send to observers, only used by the notifying thread */
+static uint32_t _next;
+
+static void _put_u16(uint8_t *buf, uint16_t val)
+{
+    buf[0] = val & 0xff;
+    buf[1] = val >> 8;
+}
+
+static void _put_u32(uint8_t *buf, uint32_t val)
+{
+    _put_u16(buf, val & 0xffff);
+    _put_u16(buf + 2, val >> 16);
+}
+
+static uint16_t _dt(const accel_sample_t *sample, uint32_t *prev_time)
+{
+    uint32_t dt = (sample->time - *prev_time) / SAMPLES_DT_UNIT_US;
+
+    *prev_time = sample->time;
+
+    return (dt > UINT16_MAX) ? UINT16_MAX : dt;
+}
+
+/* writes samples [first, first + cnt) into buf, returns the length */
+static size_t _encode(uint8_t *buf, uint32_t first, uint32_t cnt)
+{
+    const accel_sample_t *sample = sampler_history(first);
+    uint32_t prev_time = sample ? sample->time : 0;
+    uint8_t *pos = buf + SAMPLES_HDR_LEN;
+
+    _put_u32(buf, first);
+    _put_u32(buf + 4, prev_time);
+
+    for (uint32_t seq = first; seq < first + cnt; seq++) {
+        sample = sampler_history(seq);
+        if (sample == NULL) {
+            break;
+        }
+        memcpy(pos, sample->acc, sizeof(sample->acc));
+        _put_u16(pos + sizeof(sample->acc), _dt(sample, &prev_time));
+        pos += SAMPLES_RECORD_LEN;
+    }
+
+    return pos - buf;
+}
+
+/* the samples from since on, block-wise */
+static ssize_t _backlog(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                        uint32_t since)
+{
+    coap_block_slicer_t slicer;
+    uint32_t head = sampler_seq();
+
+    if ((int32_t)(since - sampler_history_start()) < 0) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_NOT_FOUND);
+    }
+    if ((int32_t)(head - since) < 0) {
+        since = head;
+    }
+
+    coap_block2_init(pdu, &slicer);
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_OCTET);
+    coap_opt_add_block2(pdu, &slicer, 1);
+    ssize_t plen = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+
+    const accel_sample_t *sample = sampler_history(since);
+    uint32_t prev_time = sample ? sample->time : 0;
+    uint8_t *pos = pdu->payload;
+    uint8_t hdr[SAMPLES_HDR_LEN];
+
+    _put_u32(hdr, since);
+    _put_u32(hdr + 4, prev_time);
+    pos += coap_blockwise_put_bytes(&slicer, pos, hdr, sizeof(hdr));
+
+    /* the slicer only copies what falls into the requested block */
+    for (uint32_t seq = since; seq != head; seq++) {
+        uint8_t dt[2];
+
+        sample = sampler_history(seq);
+        if (sample == NULL) {
+            break;
+        }
+        _put_u16(dt, _dt(sample, &prev_time));
+        pos += coap_blockwise_put_bytes(&slicer, pos, sample->acc,
+                                        sizeof(sample->acc));
+        pos += coap_blockwise_put_bytes(&slicer, pos, dt, sizeof(dt));
+    }
+
+    coap_block2_finish(&slicer);
+
+    if (!sampler_history_valid(since)) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_SERVICE_UNAVAILABLE);
+    }
+
+    return plen + (pos - pdu->payload);
+}
+
+ssize_t samples_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                        coap_request_ctx_t *ctx)
+{
+    (void)ctx;
+
+    const char *since;
+    size_t since_len;
+
+    if (coap_find_uri_query(pdu, "since", &since, &since_len)) {
+        return _backlog(pdu, buf, len, scn_u32_dec(since, since_len));
+    }
+
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_OCTET);
+    size_t resp_len = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+
+    uint32_t head = sampler_seq();
+    uint32_t first = sampler_history_start();
+    uint32_t max = (pdu->payload_len - SAMPLES_HDR_LEN) / SAMPLES_RECORD_LEN;
+
+    if (max > CONFIG_SAMPLES_BATCH) {
+        max = CONFIG_SAMPLES_BATCH;
+    }
+    if (head - first > max) {
+        first = head - max;
+    }
+
+    resp_len += _encode(pdu->payload, first, head - first);
+
+    if (!sampler_history_valid(first)) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_SERVICE_UNAVAILABLE);
+    }
+
+    return resp_len;
+}
+
+void samples_notify(const coap_resource_t *resource)
+{
+    uint32_t head = sampler_seq();
+    uint32_t start = sampler_history_start();
+
+    /* samples that were overwritten before being sent are skipped */
+    if ((int32_t)(_next - start) < 0) {
+        _next = start;
+    }
+    if (head - _next < CONFIG_SAMPLES_BATCH) {
+        return;
+    }
+
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    size_t len;
+    uint32_t cnt;
+
+    switch (gcoap_obs_init(&pdu, &buf[0], CONFIG_GCOAP_PDU_BUF_SIZE, resource)) {
+    case GCOAP_OBS_INIT_OK:
+        coap_opt_add_format(&pdu, COAP_FORMAT_OCTET);
+        len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+        cnt = (pdu.payload_len - SAMPLES_HDR_LEN) / SAMPLES_RECORD_LEN;
+        if (cnt > head - _next) {
+            cnt = head - _next;
+        }
+        len += _encode(pdu.payload, _next, cnt);
+        if (sampler_history_valid(_next)) {
+            gcoap_obs_send(&buf[0], len, resource);
+        }
+        _next += cnt;
+        break;
+    case GCOAP_OBS_INIT_UNUSED:
+        _next = head;
+        break;
+    case GCOAP_OBS_INIT_ERR:
+        DEBUG("samples: error initializing /samples notification\n");
+        break;
+    }
+}
@@ -0,0 +1,52 @@
+/**
+ * @file
+ * @brief       /samples resource streaming raw accelerometer samples
+ *
+ * The payload (application/octet-stream) is a header followed by one record
+ * per sample, all little endian:
+ *
+ *      header: uint32 seq of the first sample, uint32 its time in us
+ *      record: int16 x, int16 y, int16 z in mg,
+ *              uint16 time since the previous record in 100us (0 for the first)
+ *
+ * GET returns the latest CONFIG_SAMPLES_BATCH samples, Observe notifications
+ * carry every new sample in batches. GET with `?since=<seq>` returns all
+ * buffered samples from seq on, using Block2 if needed.
+ */
+
+#ifndef SAMPLES_H
+#define SAMPLES_H
+
+#include <stdint.h>
+
+#include "net/gcoap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Number of new samples that trigger a notification
+ */
+#ifndef CONFIG_SAMPLES_BATCH
+#define CONFIG_SAMPLES_BATCH    (16U)
+#endif
+
+/**
+ * @brief   CoAP handler of the /samples resource
+ */
+ssize_t samples_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                        coap_request_ctx_t *ctx);
+
+/**
+ * @brief   Notifies the observers of @p resource once a batch is complete
+ *
+ * Call this whenever new samples were taken.
+ */
+void samples_notify(const coap_resource_t *resource);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLES_H */
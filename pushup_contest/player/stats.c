@@ -0,0 +1,258 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__GLIBC__) || defined(_NEWLIB_VERSION)
+#include <malloc.h>
+#endif
+
+#include "bitarithm.h"
+#include "container.h"
+#include "event/periodic.h"
+#include "event/thread.h"
+#include "nanocbor/nanocbor.h"
+#include "net/gcoap.h"
+#include "sched.h"
+#include "thread.h"
+#include "ztimer.h"
+
+#include "sampler.h"
+#include "stats.h"
+
+enum {
+    STATS_KEY_SAMPLES,
+    STATS_KEY_DROPPED,
+    STATS_KEY_LATENCY,
+    STATS_KEY_HANDLERS,
+    STATS_KEY_NOTIFICATIONS,
+    STATS_KEY_STACKS,
+    STATS_KEY_HEAP,
+    STATS_KEY_NUMOF,
+};
+
+static uint32_t _latency[STATS_HIST_BUCKETS];
+static uint32_t _notifications[STATS_NOTIFY_NUMOF];
+
+static const gcoap_listener_t *_listener;
+static const coap_resource_t *_resource;
+
+/* threads created with THREAD_CREATE_STACKTEST */
+static kernel_pid_t _stacks[CONFIG_STATS_STACKS_MAX];
+static unsigned _stacks_numof;
+
+/* too large for the stack of the shared event thread */
+static uint8_t _buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+
+static void _on_notify(event_t *ev);
+
+static event_t _ev_notify = { .handler = _on_notify };
+static event_periodic_t _periodic;
+
+void stats_detection_latency(uint32_t us)
+{
+    unsigned bucket = 0;
+
+    if (us >= STATS_HIST_BASE_US) {
+        bucket = bitarithm_msb(us / STATS_HIST_BASE_US) + 1;
+        if (bucket >= STATS_HIST_BUCKETS) {
+            bucket = STATS_HIST_BUCKETS - 1;
+        }
+    }
+
+    _latency[bucket]++;
+}
+
+void stats_notification(stats_notify_t result)
+{
+    _notifications[result]++;
+}
+
+void stats_watch_stack(kernel_pid_t pid)
+{
+    assert(_stacks_numof < CONFIG_STATS_STACKS_MAX);
+
+    if ((pid > KERNEL_PID_UNDEF) && (_stacks_numof < CONFIG_STATS_STACKS_MAX)) {
+        _stacks[_stacks_numof++] = pid;
+    }
+}
+
+ssize_t stats_timed_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                            coap_request_ctx_t *ctx)
+{
+    stats_timing_t *timing = coap_request_ctx_get_context(ctx);
+    uint32_t start = ztimer_now(ZTIMER_USEC);
+
+    ssize_t res = timing->handler(pdu, buf, len, ctx);
+
+    uint32_t duration = ztimer_now(ZTIMER_USEC) - start;
+
+    timing->count++;
+    timing->total_us += duration;
+    if (duration > timing->max_us) {
+        timing->max_us = duration;
+    }
+
+    return res;
+}
+
+static bool _heap_used(size_t *used)
+{
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+    *used = mallinfo2().uordblks;
+    return true;
+#elif defined(__GLIBC__) || defined(_NEWLIB_VERSION)
+    *used = mallinfo().uordblks;
+    return true;
+#else
+    (void)used;
+    return false;
+#endif
+}
+
+static void _encode_uint_array(nanocbor_encoder_t *enc, const uint32_t *vals,
+                               size_t len)
+{
+    nanocbor_fmt_array(enc, len);
+    for (size_t i = 0; i < len; i++) {
+        nanocbor_fmt_uint(enc, vals[i]);
+    }
+}
+
+static void _encode_handlers(nanocbor_encoder_t *enc)
+{
+    nanocbor_fmt_array(enc, _listener->resources_len);
+
+    for (size_t i = 0; i < _listener->resources_len; i++) {
+        const coap_resource_t *resource = &_listener->resources[i];
+
+        if (resource->handler != stats_timed_handler) {
+            nanocbor_fmt_null(enc);
+            continue;
+        }
+
+        const stats_timing_t *timing = resource->context;
+        uint32_t count = timing->count;
+
+        nanocbor_fmt_array(enc, 3);
+        nanocbor_fmt_uint(enc, count);
+        nanocbor_fmt_uint(enc, count ? timing->total_us / count : 0);
+        nanocbor_fmt_uint(enc, timing->max_us);
+    }
+}
+
+static void _encode_stacks(nanocbor_encoder_t *enc)
+{
+    nanocbor_fmt_array_indefinite(enc);
+
+#ifdef DEVELHELP
+    for (unsigned i = 0; i < _stacks_numof; i++) {
+        kernel_pid_t pid = _stacks[i];
+        thread_t *thread = thread_get(pid);
+
+        if (thread == NULL) {
+            continue;
+        }
+
+        nanocbor_fmt_array(enc, 3);
+        nanocbor_fmt_uint(enc, pid);
+        nanocbor_fmt_uint(enc, thread_get_stacksize(thread));
+        nanocbor_fmt_uint(enc,
+                          thread_measure_stack_free(thread_get_stackstart(thread)));
+    }
+#endif
+
+    nanocbor_fmt_end_indefinite(enc);
+}
+
+/* returns the length of the encoded statistics, -ENOBUFS if they did not fit */
+static ssize_t _encode(uint8_t *buf, size_t len)
+{
+    nanocbor_encoder_t enc;
+    size_t heap;
+
+    nanocbor_encoder_init(&enc, buf, len);
+    nanocbor_fmt_map(&enc, STATS_KEY_NUMOF);
+
+    nanocbor_fmt_uint(&enc, STATS_KEY_SAMPLES);
+    nanocbor_fmt_uint(&enc, sampler_seq());
+
+    nanocbor_fmt_uint(&enc, STATS_KEY_DROPPED);
+    nanocbor_fmt_uint(&enc, sampler_dropped());
+
+    nanocbor_fmt_uint(&enc, STATS_KEY_LATENCY);
+    _encode_uint_array(&enc, _latency, ARRAY_SIZE(_latency));
+
+    nanocbor_fmt_uint(&enc, STATS_KEY_HANDLERS);
+    _encode_handlers(&enc);
+
+    nanocbor_fmt_uint(&enc, STATS_KEY_NOTIFICATIONS);
+    _encode_uint_array(&enc, _notifications, ARRAY_SIZE(_notifications));
+
+    nanocbor_fmt_uint(&enc, STATS_KEY_STACKS);
+    _encode_stacks(&enc);
+
+    nanocbor_fmt_uint(&enc, STATS_KEY_HEAP);
+    if (_heap_used(&heap)) {
+        nanocbor_fmt_uint(&enc, heap);
+    }
+    else {
+        nanocbor_fmt_null(&enc);
+    }
+
+    /* the encoder keeps counting once the buffer is full */
+    if (nanocbor_encoded_len(&enc) > len) {
+        return -ENOBUFS;
+    }
+
+    return nanocbor_encoded_len(&enc);
+}
+
+ssize_t stats_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                      coap_request_ctx_t *ctx)
+{
+    (void)ctx;
+
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_CBOR);
+    size_t resp_len = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+
+    ssize_t payload_len = _encode(pdu->payload, pdu->payload_len);
+    if (payload_len < 0) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_INTERNAL_SERVER_ERROR);
+    }
+
+    return resp_len + payload_len;
+}
+
+static void _on_notify(event_t *ev)
+{
+    (void)ev;
+
+    coap_pkt_t pdu;
+
+    if (gcoap_obs_init(&pdu, _buf, sizeof(_buf), _resource) != GCOAP_OBS_INIT_OK) {
+        return;
+    }
+
+    coap_opt_add_format(&pdu, COAP_FORMAT_CBOR);
+    size_t len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+
+    ssize_t payload_len = _encode(pdu.payload, pdu.payload_len);
+    if (payload_len < 0) {
+        return;
+    }
+
+    gcoap_obs_send(_buf, len + payload_len, _resource);
+}
+
+void stats_init(const gcoap_listener_t *listener,
+                const coap_resource_t *resource)
+{
+    _listener = listener;
+    _resource = resource;
+
+    event_periodic_init(&_periodic, ZTIMER_MSEC, EVENT_PRIO_LOWEST, &_ev_notify);
+    event_periodic_start(&_periodic, CONFIG_STATS_NOTIFY_MS);
+}
@@ -0,0 +1,134 @@
+/**
+ * @file
+ * @brief       /stats resource with runtime statistics of the player
+ *
+ * The payload is a CBOR map (application/cbor) with small integer keys:
+ *
+ *      0: samples taken since boot
+ *      1: samples dropped because the detection did not keep up
+ *      2: detection latency histogram, array of STATS_HIST_BUCKETS counters.
+ *         Bucket 0 counts latencies below STATS_HIST_BASE_US, every further
+ *         bucket twice the range of the previous one, the last one is open.
+ *      3: CoAP handler timing, one [count, average us, max us] per resource
+ *         in the order of /.well-known/core
+ *      4: /count notifications [sent, without observer, failed]
+ *      5: stack usage, one [pid, size, free] per thread registered with
+ *         stats_watch_stack() (needs DEVELHELP)
+ *      6: heap bytes in use, null if unknown
+ *
+ * Observers are notified every CONFIG_STATS_NOTIFY_MS.
+ *
+ * Every counter has a single writer and is only incremented, so updating
+ * them costs a few instructions and no locking. Readers may see values of
+ * different counters from slightly different points in time.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+#include "net/gcoap.h"
+#include "sched.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Maximum number of threads whose stack usage is reported
+ */
+#ifndef CONFIG_STATS_STACKS_MAX
+#define CONFIG_STATS_STACKS_MAX (4U)
+#endif
+
+/**
+ * @brief   Interval in which observers of /stats are notified in ms
+ */
+#ifndef CONFIG_STATS_NOTIFY_MS
+#define CONFIG_STATS_NOTIFY_MS  (5000U)
+#endif
+
+/**
+ * @brief   Number of buckets of the detection latency histogram
+ */
+#define STATS_HIST_BUCKETS      (8U)
+
+/**
+ * @brief   Upper bound of the first histogram bucket in us
+ */
+#define STATS_HIST_BASE_US      (64U)
+
+/**
+ * @brief   Outcome of a notification
+ */
+typedef enum {
+    STATS_NOTIFY_SENT,          /**< notification sent */
+    STATS_NOTIFY_UNOBSERVED,    /**< nobody observes the resource */
+    STATS_NOTIFY_FAILED,        /**< unable to build or send it */
+    STATS_NOTIFY_NUMOF,         /**< number of outcomes */
+} stats_notify_t;
+
+/**
+ * @brief   Timing of a CoAP handler, use as context of stats_timed_handler()
+ */
+typedef struct {
+    coap_handler_t handler;     /**< the handler that is timed */
+    uint32_t count;             /**< number of requests handled */
+    uint32_t total_us;          /**< time spent in the handler in us */
+    uint32_t max_us;            /**< longest time spent in the handler in us */
+} stats_timing_t;
+
+/**
+ * @brief   Static initializer of a stats_timing_t for @p h
+ */
+#define STATS_TIMING(h)         { .handler = h }
+
+/**
+ * @brief   Starts notifying the observers of @p resource
+ *
+ * @param[in] listener  listener whose timed handlers are reported
+ * @param[in] resource  the /stats resource within @p listener
+ */
+void stats_init(const gcoap_listener_t *listener,
+                const coap_resource_t *resource);
+
+/**
+ * @brief   Reports the stack usage of a thread
+ *
+ * Only threads created with THREAD_CREATE_STACKTEST can be measured. Call
+ * this during startup, before /stats is served.
+ */
+void stats_watch_stack(kernel_pid_t pid);
+
+/**
+ * @brief   CoAP handler of the /stats resource
+ */
+ssize_t stats_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                      coap_request_ctx_t *ctx);
+
+/**
+ * @brief   Calls the handler in the stats_timing_t context and times it
+ */
+ssize_t stats_timed_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                            coap_request_ctx_t *ctx);
+
+/**
+ * @brief   Records the time from taking a sample until it was processed
+ *
+ * Must only be called from the game thread.
+ */
+void stats_detection_latency(uint32_t us);
+
+/**
+ * @brief   Records the outcome of a /count notification
+ *
+ * Must only be called from the /count notification scheduler.
+ */
+void stats_notification(stats_notify_t result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STATS_H */
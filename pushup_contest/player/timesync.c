@@ -0,0 +1,101 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "irq.h"
+#include "net/gcoap.h"
+#include "ztimer.h"
+#include "ztimer64.h"
+
+#include "timesync.h"
+
+/* "-9223372036854775808" */
+#define TIMESYNC_OFFSET_MAX_LEN     (20U)
+
+/* 64 bit, so only accessed with interrupts disabled */
+static int64_t _offset;
+static bool _synced;
+
+static int64_t _get_offset(void)
+{
+    unsigned state = irq_disable();
+    int64_t offset = _offset;
+
+    irq_restore(state);
+
+    return offset;
+}
+
+uint64_t timesync_now(void)
+{
+    return ztimer64_now(ZTIMER64_USEC) + _get_offset();
+}
+
+uint64_t timesync_from_usec(uint32_t usec)
+{
+    uint32_t age = ztimer_now(ZTIMER_USEC) - usec;
+
+    return timesync_now() - age;
+}
+
+bool timesync_synced(void)
+{
+    return _synced;
+}
+
+static ssize_t _get(coap_pkt_t *pdu, uint8_t *buf, size_t len)
+{
+    /* taken first, everything after adds to the round trip only */
+    uint64_t now = ztimer64_now(ZTIMER64_USEC);
+
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_TEXT);
+    size_t resp_len = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+
+    return resp_len + fmt_u64_dec((char *)pdu->payload, now);
+}
+
+static ssize_t _put(coap_pkt_t *pdu, uint8_t *buf, size_t len)
+{
+    char str[TIMESYNC_OFFSET_MAX_LEN + 1];
+    char *end;
+
+    if ((pdu->payload_len == 0) || (pdu->payload_len > TIMESYNC_OFFSET_MAX_LEN)) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+    }
+
+    memcpy(str, pdu->payload, pdu->payload_len);
+    str[pdu->payload_len] = '\0';
+
+    int64_t offset = strtoll(str, &end, 10);
+    if (*end != '\0') {
+        return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+    }
+
+    unsigned state = irq_disable();
+    _offset = offset;
+    _synced = true;
+    irq_restore(state);
+
+    printf("timesync: offset %s us\n", str);
+
+    return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
+}
+
+ssize_t timesync_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                         coap_request_ctx_t *ctx)
+{
+    (void)ctx;
+
+    switch (coap_method2flag(coap_get_code_detail(pdu))) {
+    case COAP_GET:
+        return _get(pdu, buf, len);
+    case COAP_PUT:
+        return _put(pdu, buf, len);
+    default:
+        return gcoap_response(pdu, buf, len, COAP_CODE_METHOD_NOT_ALLOWED);
+    }
+}
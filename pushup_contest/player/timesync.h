@@ -0,0 +1,55 @@
+/**
+ * @file
+ * @brief       Clock synchronization with the referee and /time resource
+ *
+ * The referee synchronizes the players with a Cristian/NTP style exchange:
+ * it notes its time t1, reads the local time t of the player with GET /time
+ * (text/plain, us since boot), notes t4 when the response arrives and
+ * derives the offset of the player from the exchange with the shortest round
+ * trip as `(t1 + t4) / 2 - t`. It sends that offset back with PUT /time.
+ *
+ * From then on the player reports times in the referee's timebase (us since
+ * the Unix epoch), so reps of different players can be compared directly.
+ * Before the first sync the local time is reported unchanged.
+ */
+
+#ifndef TIMESYNC_H
+#define TIMESYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "net/gcoap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Current time in the shared timebase in us
+ */
+uint64_t timesync_now(void);
+
+/**
+ * @brief   Converts a recent ZTIMER_USEC timestamp to the shared timebase
+ *
+ * @param[in] usec  timestamp taken less than one ZTIMER_USEC wrap ago
+ */
+uint64_t timesync_from_usec(uint32_t usec);
+
+/**
+ * @brief   Whether the referee has set the offset
+ */
+bool timesync_synced(void);
+
+/**
+ * @brief   CoAP handler of the /time resource
+ */
+ssize_t timesync_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                         coap_request_ctx_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMESYNC_H */
@@ -1,15 +1,54 @@
+import argparse
 import logging
 import asyncio
 import aiocoap
+import cbor2
 from enum import Enum
 import os
+import random
 import re
 import subprocess
+import time
 from concurrent.futures import ThreadPoolExecutor
+from typing import Optional
 
 
 WINNING_PUSHUP_COUNT = 10
 
+# clock sync: exchanges per player, the one with the shortest round trip is
+# used, and interval in s in which the clocks are synchronized again
+TIME_SYNC_SAMPLES = 8
+TIME_SYNC_INTERVAL = 10
+
+# time in s to wait for the other players once the first reached the winning
+# count, covers network delay and the confirmable repair of lost notifications
+DECISION_WINDOW = 2.0
+
+# a rebooted player has forgotten its observers, so observations are renewed
+# this often (in s), and retried this long after they failed
+OBSERVE_RENEW_INTERVAL = 30
+OBSERVE_RETRY_DELAY = 2
+
+# keys of the /reps payload (see player/reps.h)
+REPS_KEY_FIRST = 6
+REPS_KEY_REPS = 7
+
+# winning reps closer than this (plus the sync uncertainty of both players)
+# are a tie
+TIE_TOLERANCE_US = 1000
+
+# multicast group all players join (CONFIG_GROUP_ADDR on the player)
+GROUP_ADDRESS = "ff02::7075"
+# the players start this long after a group start was sent, enough for the
+# multicast and the unicast repetition for players that missed it
+GROUP_START_DELAY_US = 500_000
+# time in s the answers to the multicast are collected, players that did not
+# answer by then are polled by unicast
+GROUP_SETTLE_TIME = 0.05
+
+# control the players with one multicast request per command (--group)
+group_mode = False
+
 
 class PlayerColor(Enum):
     OFF = 0
@@ -22,12 +61,87 @@ class Player:
     host: str
     color: PlayerColor
     count: int = 0
+    # sequence number of the last /count state received
+    seq: int = -1
+    # boot epoch of the player the sequence number belongs to
+    epoch: Optional[int] = None
+    # time of the rep that reached the winning count, shared timebase in us
+    win_time: Optional[int] = None
+    # uncertainty of the clock offset in us
+    sync_error: int = 0
+    # lookup of the exact win_time from /reps, if the winning rep was skipped
+    win_time_lookup: Optional[asyncio.Future] = None
 
     def __init__(self, host: str, color: PlayerColor):
         self.host = host
         self.color = color
 
 
+def now_us() -> int:
+    return time.time_ns() // 1000
+
+
+async def send_group_command(
+    protocol: aiocoap.Context, players: set[Player], command: str
+) -> list[Player]:
+    """Sends command to all players at once, returns the players that did
+    not acknowledge it."""
+    command_id = random.getrandbits(31)
+    payload = f"{command_id} {command}".encode("ascii")
+
+    message = aiocoap.Message(
+        mtype=aiocoap.Type.NON,
+        code=aiocoap.Code.POST,
+        uri=f"coap://[{GROUP_ADDRESS}]/group",
+        payload=payload,
+    )
+    request = protocol.request(message)
+    # hosts of the players that answered the multicast
+    acknowledged: set[str] = set()
+
+    async def collect():
+        # the players answer by unicast, each answer is a response here
+        async for response in request.responses:
+            if response.code.is_successful():
+                acknowledged.add(str(response.remote.hostinfo))
+
+    try:
+        await asyncio.wait_for(collect(), GROUP_SETTLE_TIME)
+    except asyncio.TimeoutError:
+        pass
+    except Exception as e:
+        print(f"Group command {command!r} failed, sending it by unicast:")
+        print(e)
+
+    async def acknowledge(player: Player) -> bool:
+        try:
+            message = aiocoap.Message(
+                code=aiocoap.Code.GET,
+                uri=f"coap://{player.host}/group",
+            )
+            response = await protocol.request(message).response
+            if response.payload.decode("ascii") == str(command_id):
+                return True
+
+            # missed the multicast, the command id makes repeating it safe
+            message = aiocoap.Message(
+                code=aiocoap.Code.POST,
+                uri=f"coap://{player.host}/group",
+                payload=payload,
+            )
+            response = await protocol.request(message).response
+            return response.code.is_successful()
+        except Exception as e:
+            print(f"No acknowledgement from {player.host}:")
+            print(e)
+            return False
+
+    # players that did not answer in time are asked concurrently
+    pending = [player for player in players if player.host not in acknowledged]
+    acks = await asyncio.gather(*(acknowledge(player) for player in pending))
+    return [player for player, ack in zip(pending, acks) if not ack]
+
+
 # logging setup
 logging.basicConfig(level=logging.ERROR)
 logging.getLogger("coap-server").setLevel(logging.DEBUG)
@@ -101,12 +215,89 @@ async def assign_player_colors(players: set[Player]):
         await protocol.request(message).response
 
 
+async def sync_player_clock(protocol: aiocoap.Context, player: Player):
+    best = None
+
+    for _ in range(TIME_SYNC_SAMPLES):
+        message = aiocoap.Message(
+            code=aiocoap.Code.GET,
+            uri=f"coap://{player.host}/time",
+        )
+
+        t1 = now_us()
+        response = await protocol.request(message).response
+        t4 = now_us()
+
+        player_time = int(response.payload.decode("ascii"))
+        round_trip = t4 - t1
+        if best is None or round_trip < best[0]:
+            # the player read its clock half way through the round trip
+            best = (round_trip, (t1 + t4) // 2 - player_time)
+
+    round_trip, offset = best
+    message = aiocoap.Message(
+        code=aiocoap.Code.PUT,
+        uri=f"coap://{player.host}/time",
+        payload=f"{offset}".encode("ascii"),
+    )
+    await protocol.request(message).response
+
+    player.sync_error = round_trip // 2
+
+
+async def sync_clocks(protocol: aiocoap.Context, players: set[Player]):
+    for player in players:
+        try:
+            await sync_player_clock(protocol, player)
+        except Exception as e:
+            print(f"Failed to sync clock of {player.host}:")
+            print(e)
+
+
+async def resync_clocks(protocol: aiocoap.Context, players: set[Player]):
+    # compensates the drift of the player clocks
+    while True:
+        await asyncio.sleep(TIME_SYNC_INTERVAL)
+        await sync_clocks(protocol, players)
+
+
+async def fetch_rep_time(
+    protocol: aiocoap.Context, player: Player, number: int
+) -> Optional[int]:
+    """Returns when rep number (counting from 1) was done, shared timebase in
+    us, or None if the rep log of the player does not have it."""
+    message = aiocoap.Message(
+        code=aiocoap.Code.GET,
+        uri=f"coap://{player.host}/reps?since={number - 1}",
+    )
+    response = await protocol.request(message).response
+    reps = cbor2.loads(response.payload)
+
+    # /fake_pushup reps are counted but not logged, and the log only keeps
+    # the latest reps
+    if reps[REPS_KEY_FIRST] != number - 1 or not reps[REPS_KEY_REPS]:
+        return None
+
+    start, _bottom, end, _depth = reps[REPS_KEY_REPS][0]
+    return start + end * 1000
+
+
 async def observe_players(players: set[Player]):
     protocol = await aiocoap.Context.create_client_context()
 
+    async def lookup_win_time(player: Player):
+        try:
+            win_time = await fetch_rep_time(protocol, player, WINNING_PUSHUP_COUNT)
+        except Exception as e:
+            print(f"Failed to fetch the reps of {player.host}:")
+            print(e)
+            return
+        # None after a reset while fetching
+        if win_time is not None and player.win_time is not None:
+            player.win_time = win_time
+
     # observe the count of each player
     def observation_callback(response):
-        pushup_count = int(response.payload)
         player = list(
             filter(
                 lambda player: player.host == str(response.remote.hostinfo),
@@ -114,52 +305,146 @@ async def observe_players(players: set[Player]):
             )
         )[0]
 
-        player.count = int(response.payload.decode("utf-8"))
-
-        if pushup_count == WINNING_PUSHUP_COUNT:
-            print(f"The winner is: {player.color.name} {player.host}")
-
-            # set player to winning state
-            message = aiocoap.Message(
-                code=aiocoap.Code.POST,
-                uri=f"coap://{player.host}/set_to_winner",
-            )
-            protocol.request(message).response
+        # payload is "<count> <seq> <time> <epoch>", notifications may be
+        # coalesced or arrive out of order, so only newer states are taken
+        fields = response.payload.decode("utf-8").split()
+        pushup_count = int(fields[0])
+        seq = int(fields[1]) if len(fields) > 1 else player.seq + 1
+
+        # the sequence number starts over when the player reboots
+        epoch = int(fields[3]) if len(fields) > 3 else None
+        if epoch != player.epoch:
+            player.epoch = epoch
+            player.seq = -1
+
+        if seq <= player.seq:
+            return
+
+        previous_count = player.count
+        player.seq = seq
+        player.count = pushup_count
+
+        if pushup_count == previous_count:
+            # repeated state, e.g. the confirmable repair notification
+            return
+
+        if (
+            pushup_count >= WINNING_PUSHUP_COUNT
+            and previous_count < WINNING_PUSHUP_COUNT
+        ):
+            first_finisher = all(other.win_time is None for other in players)
+            player.win_time = int(fields[2]) if len(fields) > 2 else now_us()
+            print(f"{player.color.name} finished")
+
+            # coalesced notifications can skip the winning count, the reported
+            # time then belongs to a later rep and is replaced by the exact one
+            if pushup_count > WINNING_PUSHUP_COUNT:
+                player.win_time_lookup = asyncio.ensure_future(
+                    lookup_win_time(player)
+                )
 
-            # set other players to loosing state
-            for loosing_player in players:
-                if loosing_player != player:
-                    message = aiocoap.Message(
-                        code=aiocoap.Code.POST,
-                        uri=f"coap://{loosing_player.host}/set_to_looser",
-                    )
-                    protocol.request(message).response
-
-            # play winning player sound
-            play_winner_sound(player.color)
+            # the winner is decided by rep time, not by arrival order
+            if first_finisher:
+                asyncio.get_event_loop().call_later(
+                    DECISION_WINDOW, lambda: asyncio.ensure_future(decide_winner())
+                )
         else:
             print(f"{player.color.name} pushup count: {pushup_count}")
             play_counter_sound(player.color)
 
-    async def observe_resource(uri: str):
-        message = aiocoap.Message(code=aiocoap.Code.GET)
-        message.set_request_uri(uri)
-        # set observe bit from None to 0
-        message.opt.observe = 0
-        observation_is_over = asyncio.get_event_loop().create_future()
+    async def decide_winner():
+        lookups = [
+            player.win_time_lookup
+            for player in players
+            if player.win_time_lookup is not None
+        ]
+        await asyncio.gather(*lookups)
+        for player in players:
+            player.win_time_lookup = None
+
+        finishers = [player for player in players if player.win_time is not None]
+        if not finishers:
+            # reset while waiting for the decision
+            return
+
+        first = min(finishers, key=lambda player: player.win_time)
+        winners = [
+            player
+            for player in finishers
+            if player.win_time - first.win_time
+            <= TIE_TOLERANCE_US + player.sync_error + first.sync_error
+        ]
+
+        if len(winners) > 1:
+            names = ", ".join(f"{player.color.name} {player.host}" for player in winners)
+            print(f"Tie between: {names}")
+        else:
+            print(f"The winner is: {first.color.name} {first.host}")
 
-        request = protocol.request(message)
-        try:
-            if request.observation:
-                request.observation.register_callback(observation_callback)
+        if group_mode:
+            colors = " ".join(str(player.color.value) for player in winners)
+            asyncio.ensure_future(
+                send_group_command(protocol, players, f"result {colors}")
+            )
+            play_winner_sound(first.color)
+            return
+
+        for player in players:
+            if player in winners:
+                # set player to winning state
+                message = aiocoap.Message(
+                    code=aiocoap.Code.POST,
+                    uri=f"coap://{player.host}/set_to_winner",
+                )
+            else:
+                # set player to loosing state
+                message = aiocoap.Message(
+                    code=aiocoap.Code.POST,
+                    uri=f"coap://{player.host}/set_to_looser",
+                )
+            protocol.request(message).response
+
+        # play winning player sound
+        play_winner_sound(first.color)
 
-                await request.response
-                await observation_is_over
-        finally:
-            if not request.response.done():
-                request.response.cancel()
-            if request.observation and not request.observation.cancelled:
-                request.observation.cancel()
+    async def observe_resource(uri: str):
+        while True:
+            message = aiocoap.Message(code=aiocoap.Code.GET)
+            message.set_request_uri(uri)
+            # set observe bit from None to 0
+            message.opt.observe = 0
+            observation_is_over = asyncio.get_event_loop().create_future()
+
+            def observation_error(e):
+                if not observation_is_over.done():
+                    observation_is_over.set_result(e)
+
+            request = protocol.request(message)
+            try:
+                if request.observation:
+                    request.observation.register_callback(observation_callback)
+                    request.observation.register_errback(observation_error)
+
+                # the response to the registration carries the current state
+                observation_callback(await request.response)
+                error = await asyncio.wait_for(
+                    observation_is_over, OBSERVE_RENEW_INTERVAL
+                )
+                print(f"Observation of {uri} ended:")
+                print(error)
+                await asyncio.sleep(OBSERVE_RETRY_DELAY)
+            except asyncio.TimeoutError:
+                # renewed in case the player rebooted meanwhile
+                pass
+            except Exception as e:
+                print(f"Failed to observe {uri}:")
+                print(e)
+                await asyncio.sleep(OBSERVE_RETRY_DELAY)
+            finally:
+                if not request.response.done():
+                    request.response.cancel()
+                if request.observation and not request.observation.cancelled:
+                    request.observation.cancel()
 
     tasks = [observe_resource(f"coap://{player.host}/count") for player in players]
     await asyncio.gather(*tasks)
@@ -186,6 +471,17 @@ async def start_game_cli(players: set[Player]):
             for player in players:
                 print(f"{player.color.name} ({player.host})")
 
+        elif command == "start" and group_mode:
+            # all players start at the same time, whenever they got the command
+            start_time = now_us() + GROUP_START_DELAY_US
+            missing = await send_group_command(
+                protocol, players, f"start {start_time}"
+            )
+            if missing:
+                print(f"{len(missing)} players did not acknowledge the start")
+
+            print("Game started:")
+
         elif command == "start":
             for player in players:
                 message = aiocoap.Message(
@@ -201,10 +497,21 @@ async def start_game_cli(players: set[Player]):
             for player in players:
                 print(f"{player.color.name}: {player.count}")
 
+        elif command == "reset" and group_mode:
+            for player in players:
+                player.count = 0
+                player.win_time = None
+            missing = await send_group_command(protocol, players, "reset")
+            if missing:
+                print(f"{len(missing)} players did not acknowledge the reset")
+
+            print("Players have been reset.")
+
         elif command == "reset":
             # reset count of all players
             for player in players:
                 player.count = 0
+                player.win_time = None
                 message = aiocoap.Message(
                     code=aiocoap.Code.POST,
                     uri=f"coap://{player.host}/reset",
@@ -257,13 +564,29 @@ async def main():
         if players:
             await assign_player_colors(players)
 
-            # Start Game
-            await asyncio.gather(
-                observe_players(players),
-                start_game_cli(players),
-            )
+            # one context for all synchronizations, each one opens a socket
+            sync_protocol = await aiocoap.Context.create_client_context()
+            try:
+                await sync_clocks(sync_protocol, players)
+
+                # Start Game
+                await asyncio.gather(
+                    observe_players(players),
+                    start_game_cli(players),
+                    resync_clocks(sync_protocol, players),
+                )
+            finally:
+                await sync_protocol.shutdown()
 
 
 if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Pushup contest referee")
+    parser.add_argument(
+        "--group",
+        action="store_true",
+        help="control the players with one multicast request per command",
+    )
+    group_mode = parser.parse_args().group
+
     loop = asyncio.get_event_loop()
     loop.run_until_complete(main())
@@ -0,0 +1,93 @@
+"""Generates synthetic accelerometer traces for the saul_trace replay driver.
+
+A repetition is modelled as a negative lobe on the z axis while the player
+lowers themselves, followed by a positive lobe while pushing up. The sample
+at the end of every repetition is marked as ground truth.
+
+usage: python3 gen_trace.py [--rate HZ] [--tilt DEG] [--binary] OUT
+"""
+
+import argparse
+import math
+import random
+import struct
+
+GRAVITY_MG = 1000
+NOISE_MG = 12
+AMPLITUDE_MG = 300
+IDLE_S = 2.0
+
+# duration of each repetition in seconds, includes some fast ones that the
+# old 200ms detection missed
+REP_DURATIONS = [2.0, 2.0, 1.6, 1.6, 1.2, 1.2, 1.0, 0.9, 0.8, 0.8]
+
+
+def generate(rate: int, tilt_deg: float = 0.0, seed: int = 1):
+    rnd = random.Random(seed)
+    # board slightly tilted, gravity spread over all three axes, optionally
+    # rotated around the x axis to simulate a different mounting
+    rot = math.radians(tilt_deg)
+    axis = (
+        0.10,
+        -0.05 * math.cos(rot) - math.sin(rot),
+        -0.05 * math.sin(rot) + math.cos(rot),
+    )
+    samples = []
+    t = 0.0
+    period = 1.0 / rate
+
+    def add(z_motion: float, rep: bool):
+        g = GRAVITY_MG + z_motion
+        x = g * axis[0] + rnd.gauss(0, NOISE_MG)
+        y = g * axis[1] + rnd.gauss(0, NOISE_MG)
+        z = g * axis[2] + rnd.gauss(0, NOISE_MG)
+        samples.append((round(t * 1000), round(x), round(y), round(z), int(rep)))
+
+    while t < IDLE_S:
+        add(0, False)
+        t += period
+
+    for duration in REP_DURATIONS:
+        half = duration / 2
+        start = t
+        while t - start < duration:
+            phase = t - start
+            if phase < half:
+                motion = -AMPLITUDE_MG * math.sin(math.pi * phase / half)
+            else:
+                motion = AMPLITUDE_MG * math.sin(math.pi * (phase - half) / half)
+            add(motion, t + period - start >= duration)
+            t += period
+
+    end = t + IDLE_S
+    while t < end:
+        add(0, False)
+        t += period
+
+    return samples
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--rate", type=int, default=50)
+    parser.add_argument("--tilt", type=float, default=0.0)
+    parser.add_argument("--binary", action="store_true")
+    parser.add_argument("out")
+    args = parser.parse_args()
+
+    samples = generate(args.rate, args.tilt)
+
+    if args.binary:
+        with open(args.out, "wb") as f:
+            f.write(b"PTRC")
+            for time_ms, x, y, z, rep in samples:
+                f.write(struct.pack("<IhhhH", time_ms, x, y, z, rep))
+    else:
+        with open(args.out, "w") as f:
+            f.write("# time_ms,x,y,z,rep\n")
+            for sample in samples:
+                f.write(",".join(str(v) for v in sample) + "\n")
+
+
+if __name__ == "__main__":
+    main()
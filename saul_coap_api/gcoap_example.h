@@ -50,6 +50,22 @@ int gcoap_cli_cmd(int argc, char **argv);
  */
 void server_init(void);
 
+/**
+ * @brief   Keeps the resources of the server registered with a CoRE RD
+ *
+ * Run this once after server_init().
+ */
+void saul_rd_init(void);
+
+/**
+ * @brief   Shell command showing or setting how long readings of a SAUL
+ *          device are cached
+ * @param   argc    Number of shell arguments (including shell command name)
+ * @param   argv    Shell argument values (including shell command name)
+ * @return  Exit status of the shell command
+ */
+int saul_ttl_cmd(int argc, char **argv);
+
 /**
  * @brief   Notifies all observers registered to /cli/stats - if any
  *
@@ -31,6 +31,7 @@ static msg_t _main_msg_queue[MAIN_QUEUE_SIZE];
 
 static const shell_command_t shell_commands[] = {
     { "coap", "CoAP example", gcoap_cli_cmd },
+    { "saul_ttl", "Show or set the read cache TTL of a SAUL device", saul_ttl_cmd },
     { NULL, NULL, NULL }
 };
 
@@ -39,6 +40,7 @@ int main(void)
     /* for the thread running the shell */
     msg_init_queue(_main_msg_queue, MAIN_QUEUE_SIZE);
     server_init();
+    saul_rd_init();
     puts("gcoap example app");
 
     /* start shell */
@@ -0,0 +1,163 @@
+/**
+ * @{
+ *
+ * @file
+ * @brief       Registration of the SAUL server with a CoRE resource directory
+ *
+ * A registration is confirmable and cannot go to a multicast address, so an
+ * RD at a multicast CONFIG_SAUL_RD_ADDR is looked up first by asking for
+ * rt=core.rd. The first RD to answer gets the registration, cord_ep_standalone
+ * refreshes it. Once a refresh fails, the RD is looked up again.
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "net/cord/ep.h"
+#include "net/cord/ep_standalone.h"
+#include "net/gcoap.h"
+#include "net/ipv6/addr.h"
+#include "net/sock/util.h"
+#include "random.h"
+#include "thread.h"
+#include "thread_flags.h"
+#include "ztimer.h"
+
+#include "gcoap_example.h"
+
+#define ENABLE_DEBUG 0
+#include "debug.h"
+
+/* RD to register with, a multicast address looks it up */
+#ifndef CONFIG_SAUL_RD_ADDR
+#define CONFIG_SAUL_RD_ADDR         "[ff02::1]"
+#endif
+
+#define SAUL_RD_BACKOFF_MIN_MS      (250U)      /* first retry after a failure */
+#define SAUL_RD_BACKOFF_MAX_MS      (30000U)    /* cap of the exponential backoff */
+
+#define SAUL_RD_FLAG_DISCOVERED     (0x0001)    /* lookup answered or timed out */
+#define SAUL_RD_FLAG_LOST           (0x0002)    /* registration expired */
+
+/* cord_ep builds the registration on the stack of the caller */
+static char _rd_stack[THREAD_STACKSIZE_DEFAULT + CONFIG_GCOAP_PDU_BUF_SIZE];
+static kernel_pid_t _rd_pid;
+static sock_udp_ep_t _rd_ep;
+
+/* lookup in progress, responses to earlier ones are ignored */
+static unsigned _lookup;
+static bool _found;
+
+static bool _has_rd_link(const coap_pkt_t *pdu)
+{
+    static const char rt[] = "core.rd";
+    const size_t rt_len = sizeof(rt) - 1;
+
+    /* nodes not filtering by the query answer with all their links */
+    for (size_t i = 0; i + rt_len <= pdu->payload_len; i++) {
+        if (memcmp(&pdu->payload[i], rt, rt_len) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void _lookup_handler(const gcoap_request_memo_t *memo, coap_pkt_t *pdu,
+                            const sock_udp_ep_t *remote)
+{
+    if ((uintptr_t)memo->context != _lookup) {
+        return;
+    }
+
+    if ((memo->state == GCOAP_MEMO_RESP) && !_found
+        && (coap_get_code_class(pdu) == COAP_CLASS_SUCCESS) && _has_rd_link(pdu)) {
+        _rd_ep = *remote;
+        _found = true;
+    }
+    /* also called once the lookup timed out */
+    thread_flags_set(thread_get(_rd_pid), SAUL_RD_FLAG_DISCOVERED);
+}
+
+static int _lookup_rd(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    sock_udp_ep_t remote;
+
+    if (sock_udp_name2ep(&remote, CONFIG_SAUL_RD_ADDR) != 0) {
+        puts("saul_rd: unable to parse RD address");
+        return -EINVAL;
+    }
+    if (remote.port == 0) {
+        remote.port = CONFIG_GCOAP_PORT;
+    }
+
+    if (!ipv6_addr_is_multicast((ipv6_addr_t *)&remote.addr.ipv6)) {
+        _rd_ep = remote;
+        return 0;
+    }
+
+    gcoap_req_init(&pdu, buf, sizeof(buf), COAP_METHOD_GET, "/.well-known/core");
+    coap_opt_add_uri_query(&pdu, "rt", "core.rd");
+    ssize_t len = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+
+    _found = false;
+    _lookup++;
+    thread_flags_clear(SAUL_RD_FLAG_DISCOVERED);
+    if (gcoap_req_send(buf, len, &remote, _lookup_handler,
+                       (void *)(uintptr_t)_lookup) <= 0) {
+        return -EIO;
+    }
+    thread_flags_wait_any(SAUL_RD_FLAG_DISCOVERED);
+
+    return _found ? 0 : -ENOENT;
+}
+
+static void _on_rd_event(cord_ep_standalone_event_t event)
+{
+    if (event == CORD_EP_DEREGISTERED) {
+        thread_flags_set(thread_get(_rd_pid), SAUL_RD_FLAG_LOST);
+    }
+}
+
+/* never returns, keeps the server registered with an RD */
+static void *_rd_thread(void *arg)
+{
+    (void)arg;
+    uint32_t backoff = SAUL_RD_BACKOFF_MIN_MS;
+
+    while (1) {
+        int res = _lookup_rd();
+        if (res == 0) {
+            res = cord_ep_register(&_rd_ep, NULL);
+        }
+
+        if (res == CORD_EP_OK) {
+            puts("saul_rd: registered");
+            backoff = SAUL_RD_BACKOFF_MIN_MS;
+            thread_flags_wait_any(SAUL_RD_FLAG_LOST);
+            puts("saul_rd: registration lost");
+            continue;
+        }
+
+        DEBUG("saul_rd: not registered: %d\n", res);
+        /* jitter keeps nodes that failed together from retrying together */
+        ztimer_sleep(ZTIMER_MSEC, random_uint32_range(backoff / 2, backoff + 1));
+        backoff = (backoff < SAUL_RD_BACKOFF_MAX_MS / 2) ? backoff * 2 : SAUL_RD_BACKOFF_MAX_MS;
+    }
+
+    return NULL;
+}
+
+void saul_rd_init(void)
+{
+    cord_ep_standalone_reg_cb(_on_rd_event);
+    _rd_pid = thread_create(_rd_stack, sizeof(_rd_stack), THREAD_PRIORITY_MAIN,
+                            THREAD_CREATE_STACKTEST, _rd_thread, NULL, "saul_rd");
+}
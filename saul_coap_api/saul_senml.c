@@ -0,0 +1,329 @@
+/**
+ * @{
+ *
+ * @file
+ * @brief       SenML representations of SAUL readings
+ *
+ * @}
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "nanocbor/nanocbor.h"
+#include "phydat.h"
+
+#include "saul_senml.h"
+
+/* SenML labels in CBOR, RFC 8428 section 6 */
+#define SENML_LABEL_BASE_NAME   (-2)
+#define SENML_LABEL_NAME        (0)
+#define SENML_LABEL_UNIT        (1)
+#define SENML_LABEL_VALUE       (2)
+#define SENML_LABEL_BOOL_VALUE  (4)
+
+/* longest number written to JSON, "-32767e-128" */
+#define JSON_NUM_MAX            (12U)
+/* smallest scale written as fixed point, "-0.0032767" */
+#define JSON_DFP_MIN            (-7)
+
+static const char *const _dim_names[] = { "/0", "/1", "/2" };
+
+static_assert(ARRAY_SIZE(_dim_names) == PHYDAT_DIM,
+              "one record name is needed per dimension");
+
+/* SenML units of phydat units, values are always sent as they are, without
+ * converting them to another unit */
+static const struct {
+    uint8_t unit;
+    const char *senml;
+} _units[] = {
+    { UNIT_TEMP_C, "Cel" },
+    { UNIT_TEMP_K, "K" },
+    { UNIT_LUX, "lx" },
+    { UNIT_M, "m" },
+    { UNIT_M2, "m2" },
+    { UNIT_M3, "m3" },
+    { UNIT_A, "A" },
+    { UNIT_V, "V" },
+    { UNIT_W, "W" },
+    { UNIT_T, "T" },
+    { UNIT_COULOMB, "C" },
+    { UNIT_F, "F" },
+    { UNIT_OHM, "Ohm" },
+    { UNIT_PA, "Pa" },
+    { UNIT_CD, "cd" },
+    { UNIT_PERCENT, "%" },
+};
+
+/* SenML unit of a phydat unit, NULL if there is none */
+static const char *_unit(uint8_t unit)
+{
+    for (unsigned i = 0; i < ARRAY_SIZE(_units); i++) {
+        if (_units[i].unit == unit) {
+            return _units[i].senml;
+        }
+    }
+
+    return NULL;
+}
+
+uint8_t saul_senml_unit_from_str(const char *str, size_t len)
+{
+    for (unsigned i = 0; i < ARRAY_SIZE(_units); i++) {
+        if ((strlen(_units[i].senml) == len) && (memcmp(_units[i].senml, str, len) == 0)) {
+            return _units[i].unit;
+        }
+    }
+
+    return UNIT_UNDEF;
+}
+
+void saul_senml_cbor_init(saul_senml_cbor_t *cbor, uint8_t *buf, size_t size)
+{
+    cbor->size = size;
+    nanocbor_encoder_init(&cbor->enc, buf, size);
+    nanocbor_fmt_array_indefinite(&cbor->enc);
+}
+
+void saul_senml_cbor_add(saul_senml_cbor_t *cbor, const char *name,
+                         const phydat_t *data, int dim)
+{
+    nanocbor_encoder_t *enc = &cbor->enc;
+    const char *unit = _unit(data->unit);
+
+    for (int i = 0; i < dim; i++) {
+        bool base = (i == 0);
+        bool named = (dim > 1);
+
+        nanocbor_fmt_map(enc, 1 + base + named + (unit != NULL));
+        if (base) {
+            nanocbor_fmt_int(enc, SENML_LABEL_BASE_NAME);
+            nanocbor_put_tstr(enc, name);
+        }
+        if (named) {
+            nanocbor_fmt_int(enc, SENML_LABEL_NAME);
+            nanocbor_put_tstr(enc, _dim_names[i]);
+        }
+        if (unit) {
+            nanocbor_fmt_int(enc, SENML_LABEL_UNIT);
+            nanocbor_put_tstr(enc, unit);
+        }
+        if (data->unit == UNIT_BOOL) {
+            nanocbor_fmt_int(enc, SENML_LABEL_BOOL_VALUE);
+            nanocbor_fmt_bool(enc, data->val[i] != 0);
+        }
+        else if (data->scale == 0) {
+            nanocbor_fmt_int(enc, SENML_LABEL_VALUE);
+            nanocbor_fmt_int(enc, data->val[i]);
+        }
+        else {
+            /* exact, no float conversion needed */
+            nanocbor_fmt_int(enc, SENML_LABEL_VALUE);
+            nanocbor_fmt_decimal_frac(enc, data->scale, data->val[i]);
+        }
+    }
+}
+
+ssize_t saul_senml_cbor_finish(saul_senml_cbor_t *cbor)
+{
+    nanocbor_fmt_end_indefinite(&cbor->enc);
+
+    /* the encoder keeps counting past the end of the buffer */
+    size_t len = nanocbor_encoded_len(&cbor->enc);
+    if (len > cbor->size) {
+        return -ENOBUFS;
+    }
+
+    return len;
+}
+
+static void _json_put(saul_senml_json_t *json, const char *str, size_t len)
+{
+    if (json->pos + len <= json->size) {
+        memcpy(&json->buf[json->pos], str, len);
+    }
+    json->pos += len;
+}
+
+static void _json_str(saul_senml_json_t *json, const char *str)
+{
+    _json_put(json, str, strlen(str));
+}
+
+static void _json_num(saul_senml_json_t *json, int16_t val, int8_t scale)
+{
+    char num[JSON_NUM_MAX];
+    size_t len;
+
+    if ((scale < 0) && (scale >= JSON_DFP_MIN)) {
+        len = fmt_s16_dfp(num, val, scale);
+    }
+    else {
+        len = fmt_s16_dec(num, val);
+        if (scale != 0) {
+            num[len++] = 'e';
+            len += fmt_s16_dec(&num[len], scale);
+        }
+    }
+    _json_put(json, num, len);
+}
+
+void saul_senml_json_init(saul_senml_json_t *json, char *buf, size_t size)
+{
+    json->buf = buf;
+    json->size = size;
+    json->pos = 0;
+    json->first = true;
+    _json_str(json, "[");
+}
+
+void saul_senml_json_add(saul_senml_json_t *json, const char *name,
+                         const phydat_t *data, int dim)
+{
+    const char *unit = _unit(data->unit);
+
+    for (int i = 0; i < dim; i++) {
+        _json_str(json, json->first ? "{" : ",{");
+        json->first = false;
+
+        if (i == 0) {
+            _json_str(json, "\"bn\":\"");
+            _json_str(json, name);
+            _json_str(json, "\",");
+        }
+        if (dim > 1) {
+            _json_str(json, "\"n\":\"");
+            _json_str(json, _dim_names[i]);
+            _json_str(json, "\",");
+        }
+        if (unit) {
+            _json_str(json, "\"u\":\"");
+            _json_str(json, unit);
+            _json_str(json, "\",");
+        }
+        if (data->unit == UNIT_BOOL) {
+            _json_str(json, data->val[i] ? "\"vb\":true}" : "\"vb\":false}");
+        }
+        else {
+            _json_str(json, "\"v\":");
+            _json_num(json, data->val[i], data->scale);
+            _json_str(json, "}");
+        }
+    }
+}
+
+ssize_t saul_senml_json_finish(saul_senml_json_t *json)
+{
+    _json_str(json, "]");
+
+    if (json->pos > json->size) {
+        return -ENOBUFS;
+    }
+
+    return json->pos;
+}
+
+static int _get_value(nanocbor_value_t *it, int32_t *m, int32_t *e)
+{
+    switch (nanocbor_get_type(it)) {
+    case NANOCBOR_TYPE_UINT:
+    case NANOCBOR_TYPE_NINT:
+        *e = 0;
+        return nanocbor_get_int32(it, m);
+    case NANOCBOR_TYPE_TAG:
+        return nanocbor_get_decimal_frac(it, e, m);
+    case NANOCBOR_TYPE_FLOAT: {
+        double val;
+        if (nanocbor_get_double(it, &val) < 0) {
+            return -1;
+        }
+        /* three decimals are plenty for an actuator */
+        val *= 1000;
+        if (!((val > INT32_MIN) && (val < INT32_MAX))) {
+            return -1;
+        }
+        *m = (int32_t)(val + ((val < 0) ? -0.5 : 0.5));
+        *e = -3;
+        return 0;
+    }
+    default:
+        return -1;
+    }
+}
+
+int saul_senml_cbor_parse(const uint8_t *buf, size_t len,
+                          saul_senml_record_cb_t cb, void *arg)
+{
+    nanocbor_value_t dec;
+    nanocbor_value_t pack;
+    /* the base name stays in effect for the following records */
+    saul_senml_record_t rec = { 0 };
+
+    nanocbor_decoder_init(&dec, buf, len);
+    if (nanocbor_enter_array(&dec, &pack) < 0) {
+        return -EBADMSG;
+    }
+
+    while (!nanocbor_at_end(&pack)) {
+        nanocbor_value_t map;
+        bool has_value = false;
+
+        if (nanocbor_enter_map(&pack, &map) < 0) {
+            return -EBADMSG;
+        }
+        rec.n_len = 0;
+        rec.u_len = 0;
+
+        while (!nanocbor_at_end(&map)) {
+            int32_t label;
+            int res;
+
+            if (nanocbor_get_int32(&map, &label) < 0) {
+                return -EBADMSG;
+            }
+            switch (label) {
+            case SENML_LABEL_BASE_NAME:
+                res = nanocbor_get_tstr(&map, (const uint8_t **)&rec.bn, &rec.bn_len);
+                break;
+            case SENML_LABEL_NAME:
+                res = nanocbor_get_tstr(&map, (const uint8_t **)&rec.n, &rec.n_len);
+                break;
+            case SENML_LABEL_UNIT:
+                res = nanocbor_get_tstr(&map, (const uint8_t **)&rec.u, &rec.u_len);
+                break;
+            case SENML_LABEL_VALUE:
+                res = _get_value(&map, &rec.m, &rec.e);
+                has_value = true;
+                break;
+            case SENML_LABEL_BOOL_VALUE: {
+                bool val;
+                res = nanocbor_get_bool(&map, &val);
+                rec.m = val;
+                rec.e = 0;
+                has_value = true;
+                break;
+            }
+            default:
+                res = nanocbor_skip(&map);
+            }
+            if (res < 0) {
+                return -EBADMSG;
+            }
+        }
+        nanocbor_leave_container(&pack, &map);
+
+        if (has_value) {
+            int res = cb(&rec, arg);
+            if (res < 0) {
+                return res;
+            }
+        }
+    }
+
+    return 0;
+}
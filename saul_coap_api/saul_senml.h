@@ -0,0 +1,131 @@
+/**
+ * @{
+ *
+ * @file
+ * @brief       SenML representations of SAUL readings
+ *
+ * Each dimension of a phydat_t becomes one SenML record. The first record of
+ * a device carries the device name as base name, multi-dimensional readings
+ * name their records "/0", "/1", ... relative to it. Several devices can be
+ * added to the same pack.
+ *
+ * Packs written to SAUL devices are parsed from SenML+CBOR.
+ *
+ * @}
+ */
+
+#ifndef SAUL_SENML_H
+#define SAUL_SENML_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "nanocbor/nanocbor.h"
+#include "phydat.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   SenML+CBOR pack being written
+ */
+typedef struct {
+    nanocbor_encoder_t enc; /**< encoder writing into the output buffer */
+    size_t size;            /**< size of the output buffer */
+} saul_senml_cbor_t;
+
+/**
+ * @brief   SenML+JSON pack being written
+ */
+typedef struct {
+    char *buf;              /**< output buffer */
+    size_t size;            /**< size of @p buf */
+    size_t pos;             /**< bytes written, may exceed @p size */
+    bool first;             /**< no record written yet */
+} saul_senml_json_t;
+
+/**
+ * @brief   One SenML record with a value, as parsed from a pack
+ *
+ * The strings point into the pack and are not terminated. The name of the
+ * record is @p bn followed by @p n.
+ */
+typedef struct {
+    const char *bn;         /**< base name in effect */
+    size_t bn_len;          /**< length of @p bn */
+    const char *n;          /**< name */
+    size_t n_len;           /**< length of @p n, 0 if none */
+    const char *u;          /**< unit */
+    size_t u_len;           /**< length of @p u, 0 if none */
+    int32_t m;              /**< the value is m * 10^e, booleans are 0 or 1 */
+    int32_t e;              /**< exponent of the value */
+} saul_senml_record_t;
+
+/**
+ * @brief   Called for each record of a pack that has a value
+ *
+ * @return  0 to continue, negative to stop parsing with this error
+ */
+typedef int (*saul_senml_record_cb_t)(const saul_senml_record_t *rec, void *arg);
+
+/**
+ * @brief   Starts a SenML+CBOR pack in @p buf
+ */
+void saul_senml_cbor_init(saul_senml_cbor_t *cbor, uint8_t *buf, size_t size);
+
+/**
+ * @brief   Adds the @p dim dimensions of a reading of device @p name
+ */
+void saul_senml_cbor_add(saul_senml_cbor_t *cbor, const char *name,
+                         const phydat_t *data, int dim);
+
+/**
+ * @brief   Closes the pack
+ *
+ * @return  length of the pack
+ * @return  -ENOBUFS if it did not fit
+ */
+ssize_t saul_senml_cbor_finish(saul_senml_cbor_t *cbor);
+
+/**
+ * @brief   Starts a SenML+JSON pack in @p buf
+ */
+void saul_senml_json_init(saul_senml_json_t *json, char *buf, size_t size);
+
+/**
+ * @brief   Adds the @p dim dimensions of a reading of device @p name
+ */
+void saul_senml_json_add(saul_senml_json_t *json, const char *name,
+                         const phydat_t *data, int dim);
+
+/**
+ * @brief   Closes the pack
+ *
+ * @return  length of the pack
+ * @return  -ENOBUFS if it did not fit
+ */
+ssize_t saul_senml_json_finish(saul_senml_json_t *json);
+
+/**
+ * @brief   Calls @p cb for each record with a value in a SenML+CBOR pack
+ *
+ * @return  0 on success
+ * @return  -EBADMSG if the pack is malformed
+ * @return  the first error returned by @p cb
+ */
+int saul_senml_cbor_parse(const uint8_t *buf, size_t len,
+                          saul_senml_record_cb_t cb, void *arg);
+
+/**
+ * @brief   phydat unit of a SenML unit, UNIT_UNDEF if there is none
+ */
+uint8_t saul_senml_unit_from_str(const char *str, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAUL_SENML_H */
@@ -19,19 +19,33 @@
  * @}
  */
 
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "event/periodic.h"
+#include "event/thread.h"
 #include "fmt.h"
+#include "mbox.h"
+#include "mutex.h"
 #include "net/gcoap.h"
 #include "net/utils.h"
 #include "od.h"
 #include "flash_utils.h"
 #include "saul_reg.h"
 #include "saul.h"
+#include "random.h"
+#include "thread.h"
+#include "ztimer.h"
+#include "coap_links.h"
 #include "gcoap_example.h"
+#include "saul_senml.h"
 
 #define ENABLE_DEBUG 0
 #include "debug.h"
@@ -62,33 +76,152 @@ static const credman_credential_t credential = {
 #define SAUL_DEVICE_COUNT      (2)
 #endif
 
-static ssize_t _encode_link(const coap_resource_t *resource, char *buf,
-                            size_t maxlen, coap_link_encoder_ctx_t *context);
+/* average length of a SAUL device name, sizes the URI arena */
+#ifndef CONFIG_SAUL_NAME_LEN
+#define CONFIG_SAUL_NAME_LEN   (16)
+#endif
 
-/* CoAP resources. Must be sorted by path (ASCII order). */
-static coap_resource_t _resources[SAUL_DEVICE_COUNT];
+/* space for the SenML pack of all devices served on /saul */
+#ifndef CONFIG_SAUL_PACK_SIZE
+#define CONFIG_SAUL_PACK_SIZE  (SAUL_DEVICE_COUNT * 128)
+#endif
 
-static char *_link_params[SAUL_DEVICE_COUNT];
+/* period of the sampler reading observed devices */
+#ifndef CONFIG_SAUL_OBS_PERIOD_MS
+#define CONFIG_SAUL_OBS_PERIOD_MS  (1000U)
+#endif
 
-static gcoap_listener_t _listener;
+/* change of a value, in its raw unit, that is notified, 0 notifies every
+ * period */
+#ifndef CONFIG_SAUL_OBS_DELTA
+#define CONFIG_SAUL_OBS_DELTA      (1)
+#endif
 
-/* Adds link format params to resource list */
-static ssize_t _encode_link(const coap_resource_t *resource, char *buf,
-                            size_t maxlen, coap_link_encoder_ctx_t *context) {
-    ssize_t res = gcoap_encode_link(resource, buf, maxlen, context);
-    if (res > 0) {
-        if (_link_params[context->link_pos]
-                && (strlen(_link_params[context->link_pos]) < (maxlen - res))) {
-            if (buf) {
-                memcpy(buf+res, _link_params[context->link_pos],
-                       strlen(_link_params[context->link_pos]));
-            }
-            return res + strlen(_link_params[context->link_pos]);
-        }
-    }
+/* observers get a notification at least this often, even without change */
+#ifndef CONFIG_SAUL_OBS_MAX_AGE_S
+#define CONFIG_SAUL_OBS_MAX_AGE_S  (60U)
+#endif
 
-    return res;
-}
+/* a notification stays fresh until the next heartbeat is sampled */
+#define SAUL_OBS_MAX_AGE           (CONFIG_SAUL_OBS_MAX_AGE_S + \
+                                    (CONFIG_SAUL_OBS_PERIOD_MS + 999U) / 1000U)
+
+/* how long a reading of a sensor is reused, slow environmental sensors use
+ * CONFIG_SAUL_CACHE_TTL_SLOW_MS, actuators and event-like sensors are never
+ * cached */
+#ifndef CONFIG_SAUL_CACHE_TTL_MS
+#define CONFIG_SAUL_CACHE_TTL_MS       (500U)
+#endif
+
+#ifndef CONFIG_SAUL_CACHE_TTL_SLOW_MS
+#define CONFIG_SAUL_CACHE_TTL_SLOW_MS  (5000U)
+#endif
+
+/* threads doing reads that are too slow for the gcoap thread */
+#ifndef CONFIG_SAUL_WORKERS
+#define CONFIG_SAUL_WORKERS        (2U)
+#endif
+
+/* reads waiting for a worker, more are answered with 5.03 */
+#ifndef CONFIG_SAUL_QUEUE_LEN
+#define CONFIG_SAUL_QUEUE_LEN      (4U)
+#endif
+
+/* Max-Age of a 5.03, clients retry after it */
+#ifndef CONFIG_SAUL_RETRY_S
+#define CONFIG_SAUL_RETRY_S        (1U)
+#endif
+
+/* longest text payload of a PUT */
+#ifndef CONFIG_SAUL_WRITE_TEXT_MAX
+#define CONFIG_SAUL_WRITE_TEXT_MAX (48U)
+#endif
+
+/* average length of the link parameters of a device, sizes their arena */
+#ifndef CONFIG_SAUL_LINK_PARAMS_LEN
+#define CONFIG_SAUL_LINK_PARAMS_LEN (64U)
+#endif
+
+/* exponents accepted in writes, phydat_fit() takes it from there */
+#define SAUL_WRITE_EXP_MIN         (-30)
+#define SAUL_WRITE_EXP_MAX         (30)
+
+/* longest ?class= filter of /saul, SAUL class names are shorter */
+#define SAUL_CLASS_QUERY_MAX       (24U)
+
+/* state kept per SAUL device, the context of its resource */
+typedef struct {
+    saul_reg_t *reg;                    /* the device */
+    bool slow;                          /* reads are deferred to a worker */
+    mutex_t lock;                       /* serializes reads, guards the cache */
+    uint32_t ttl_ms;                    /* how long a reading is reused */
+    phydat_t cached;                    /* last reading */
+    int cached_dim;                     /* its dimension, <= 0 if invalid */
+    uint32_t cached_at;                 /* ZTIMER_MSEC time of that reading */
+    const coap_resource_t *resource;    /* its entry in _resources */
+    unsigned obs_format;                /* content format the observer asked for */
+    phydat_t notified;                  /* reading last notified */
+    int notified_dim;                   /* its dimension, 0 if none yet */
+    uint32_t notified_at;               /* ZTIMER_MSEC time of that notification */
+} saul_dev_t;
+
+static saul_dev_t _devs[SAUL_DEVICE_COUNT];
+static unsigned _devs_numof;
+
+/* GET answered with a separate response by a worker */
+typedef struct {
+    bool used;                          /* slot is taken */
+    saul_dev_t *saul_dev;               /* device to read, NULL for /saul */
+    sock_udp_ep_t remote;               /* the client */
+    uint8_t token[COAP_TOKEN_LENGTH_MAX];   /* token of the request */
+    uint8_t token_len;
+    uint8_t type;                       /* CON or NON, like the request */
+    uint16_t format;                    /* negotiated content format */
+    char class[SAUL_CLASS_QUERY_MAX];   /* ?class= filter of /saul */
+    uint8_t class_len;
+    uint16_t blksize;                   /* Block2 size of /saul */
+} saul_job_t;
+
+/* queued and in progress jobs */
+static saul_job_t _jobs[CONFIG_SAUL_QUEUE_LEN + CONFIG_SAUL_WORKERS];
+static mutex_t _jobs_lock = MUTEX_INIT;
+static msg_t _queue_msgs[CONFIG_SAUL_QUEUE_LEN];
+static mbox_t _queue;
+static char _worker_stacks[CONFIG_SAUL_WORKERS][THREAD_STACKSIZE_DEFAULT +
+                                                 CONFIG_GCOAP_PDU_BUF_SIZE];
+static atomic_uint _msg_id;
+
+/* one timer samples all observed devices */
+static void _on_sample(event_t *ev);
+static event_t _ev_sample = { .handler = _on_sample };
+static event_periodic_t _sampler;
+static uint8_t _obs_buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+
+/* CoAP resources, one per device and /saul. Must be sorted by path (ASCII
+ * order). */
+static coap_resource_t _resources[SAUL_DEVICE_COUNT + 1];
+
+/* link parameters, indexed like _resources, registered with the RD */
+static const char *_link_params[SAUL_DEVICE_COUNT + 1];
+static char _link_params_buf[SAUL_DEVICE_COUNT * CONFIG_SAUL_LINK_PARAMS_LEN];
+
+/* URIs of all resources, "/<name>\0" one after the other */
+static char _uris[SAUL_DEVICE_COUNT * (CONFIG_SAUL_NAME_LEN + 2)];
+
+/* resources with their link format, served on /.well-known/core */
+static coap_links_t _links;
+
+/* pack served on /saul, a block-wise transfer gets the snapshot taken for
+ * its first block. Each snapshot has its own ETag, so a client sees when
+ * another transfer replaced it in between. */
+static uint8_t _pack[CONFIG_SAUL_PACK_SIZE];
+static size_t _pack_len;
+static unsigned _pack_format;
+static char _pack_class[SAUL_CLASS_QUERY_MAX];
+static size_t _pack_class_len;
+static uint32_t _pack_etag;
+/* snapshots are taken by the gcoap thread and by workers */
+static mutex_t _pack_lock = MUTEX_INIT;
 
 void notify_observers(void)
 {
@@ -194,39 +327,884 @@ size_t phydat_to_str(const phydat_t *data, const uint8_t dim, char* buf, const s
         return dev->name;
     }
 } */
+/* GPIO backed devices answer right away, anything else may sit on a bus */
+static bool _class_slow(uint8_t class)
+{
+    return ((class & SAUL_CAT_MASK) != SAUL_CAT_ACT) && (class != SAUL_SENSE_BTN);
+}
+
+static uint32_t _class_ttl(uint8_t class)
+{
+    if ((class & SAUL_CAT_MASK) == SAUL_CAT_ACT) {
+        /* must reflect writes right away */
+        return 0;
+    }
+
+    switch (class) {
+    case SAUL_SENSE_BTN:
+    case SAUL_SENSE_COUNT:
+    case SAUL_SENSE_OCCUP:
+        /* events must not be missed */
+        return 0;
+    case SAUL_SENSE_TEMP:
+    case SAUL_SENSE_HUM:
+    case SAUL_SENSE_PRESS:
+    case SAUL_SENSE_OBJTEMP:
+    case SAUL_SENSE_CO2:
+    case SAUL_SENSE_TVOC:
+    case SAUL_SENSE_PM:
+        return CONFIG_SAUL_CACHE_TTL_SLOW_MS;
+    default:
+        return CONFIG_SAUL_CACHE_TTL_MS;
+    }
+}
+
+/* reads the device unless the cached reading is still fresh, concurrent
+ * readers of the same device wait for one read and share it */
+static int _read(saul_dev_t *saul_dev, phydat_t *data, uint32_t *ttl_left_ms)
+{
+    mutex_lock(&saul_dev->lock);
+
+    uint32_t now = ztimer_now(ZTIMER_MSEC);
+    uint32_t age = now - saul_dev->cached_at;
+    if ((saul_dev->cached_dim <= 0) || (age >= saul_dev->ttl_ms)) {
+        saul_dev->cached_dim = saul_reg_read(saul_dev->reg, &saul_dev->cached);
+        saul_dev->cached_at = now;
+        age = 0;
+    }
+    int dim = saul_dev->cached_dim;
+    *data = saul_dev->cached;
+    if (ttl_left_ms) {
+        *ttl_left_ms = (age < saul_dev->ttl_ms) ? saul_dev->ttl_ms - age : 0;
+    }
+
+    mutex_unlock(&saul_dev->lock);
+
+    return dim;
+}
+
+/* like _read() but never touches the device, for the gcoap thread: returns
+ * 0 if the reading is stale or a read is in progress */
+static int _read_cached(saul_dev_t *saul_dev, phydat_t *data, uint32_t *ttl_left_ms)
+{
+    if (!mutex_trylock(&saul_dev->lock)) {
+        return 0;
+    }
+
+    int dim = 0;
+    uint32_t age = ztimer_now(ZTIMER_MSEC) - saul_dev->cached_at;
+    if ((saul_dev->cached_dim > 0) && (age < saul_dev->ttl_ms)) {
+        dim = saul_dev->cached_dim;
+        *data = saul_dev->cached;
+        *ttl_left_ms = saul_dev->ttl_ms - age;
+    }
+
+    mutex_unlock(&saul_dev->lock);
+
+    return dim;
+}
+
+static void _invalidate(saul_dev_t *saul_dev)
+{
+    mutex_lock(&saul_dev->lock);
+    saul_dev->cached_dim = 0;
+    mutex_unlock(&saul_dev->lock);
+}
+
+int saul_ttl_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("usage: %s <device> [<ttl in ms>]\n", argv[0]);
+        return 1;
+    }
+
+    for (unsigned i = 0; i < _devs_numof; i++) {
+        saul_dev_t *saul_dev = &_devs[i];
+        if (strcmp(saul_dev->reg->name, argv[1]) != 0) {
+            continue;
+        }
+        if (argc > 2) {
+            mutex_lock(&saul_dev->lock);
+            saul_dev->ttl_ms = strtoul(argv[2], NULL, 10);
+            saul_dev->cached_dim = 0;
+            mutex_unlock(&saul_dev->lock);
+        }
+        printf("%s: %" PRIu32 " ms\n", saul_dev->reg->name, saul_dev->ttl_ms);
+        return 0;
+    }
+
+    printf("%s: no such device\n", argv[1]);
+    return 1;
+}
+
+/* writes a reading in the negotiated content format */
+static ssize_t _format_reading(unsigned format, const saul_reg_t *dev,
+                               const phydat_t *data, int dim,
+                               uint8_t *buf, size_t len)
+{
+    switch (format) {
+    case COAP_FORMAT_SENML_CBOR: {
+        saul_senml_cbor_t cbor;
+        saul_senml_cbor_init(&cbor, buf, len);
+        saul_senml_cbor_add(&cbor, dev->name, data, dim);
+        return saul_senml_cbor_finish(&cbor);
+    }
+    case COAP_FORMAT_SENML_JSON: {
+        saul_senml_json_t json;
+        saul_senml_json_init(&json, (char *)buf, len);
+        saul_senml_json_add(&json, dev->name, data, dim);
+        return saul_senml_json_finish(&json);
+    }
+    default:
+        return phydat_to_str(data, dim, (char *)buf, len);
+    }
+}
+
+static saul_job_t *_job_alloc(void)
+{
+    saul_job_t *job = NULL;
+
+    mutex_lock(&_jobs_lock);
+    for (unsigned i = 0; i < ARRAY_SIZE(_jobs); i++) {
+        if (!_jobs[i].used) {
+            job = &_jobs[i];
+            job->used = true;
+            break;
+        }
+    }
+    mutex_unlock(&_jobs_lock);
+
+    return job;
+}
+
+static void _job_free(saul_job_t *job)
+{
+    mutex_lock(&_jobs_lock);
+    job->used = false;
+    mutex_unlock(&_jobs_lock);
+}
+
+/* overloaded, the client may try again after Max-Age */
+static ssize_t _unavailable(coap_pkt_t *pdu, uint8_t *buf, size_t len)
+{
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_SERVICE_UNAVAILABLE);
+    coap_opt_add_uint(pdu, COAP_OPT_MAX_AGE, CONFIG_SAUL_RETRY_S);
+    return coap_opt_finish(pdu, COAP_OPT_FINISH_NONE);
+}
+
+/* queues the read described by @p req to a worker and acknowledges the
+ * request, the response follows separately */
+static ssize_t _defer(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                      coap_request_ctx_t *ctx, const saul_job_t *req)
+{
+    const sock_udp_ep_t *remote = coap_request_ctx_get_remote_udp(ctx);
+    saul_job_t *job = (remote != NULL) ? _job_alloc() : NULL;
+
+    if (job) {
+        *job = *req;
+        job->used = true;
+        job->remote = *remote;
+        job->token_len = coap_get_token_len(pdu);
+        memcpy(job->token, coap_get_token(pdu), job->token_len);
+        job->type = (coap_get_type(pdu) == COAP_TYPE_CON) ? COAP_TYPE_CON : COAP_TYPE_NON;
+
+        msg_t msg = { .content.ptr = job };
+        if (mbox_try_put(&_queue, &msg)) {
+            if (job->type == COAP_TYPE_NON) {
+                /* nothing to acknowledge */
+                return 0;
+            }
+            return coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_ACK, NULL, 0,
+                                  COAP_CODE_EMPTY, coap_get_id(pdu));
+        }
+        _job_free(job);
+    }
+
+    return _unavailable(pdu, buf, len);
+}
+
+/* reads the device of a deferred GET and sends the separate response */
+static void _respond(const saul_job_t *job)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    phydat_t data;
+    uint32_t ttl_left_ms;
+
+    int dim = _read(job->saul_dev, &data, &ttl_left_ms);
+
+    ssize_t hdr_len = coap_build_hdr((coap_hdr_t *)buf, job->type, job->token,
+                                     job->token_len, COAP_CODE_CONTENT,
+                                     atomic_fetch_add(&_msg_id, 1));
+    coap_pkt_init(&pdu, buf, sizeof(buf), hdr_len);
+
+    ssize_t len = -1;
+    if (dim > 0) {
+        coap_opt_add_format(&pdu, job->format);
+        coap_opt_add_uint(&pdu, COAP_OPT_MAX_AGE, ttl_left_ms / 1000U);
+        len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+        ssize_t payload_len = _format_reading(job->format, job->saul_dev->reg, &data, dim,
+                                              pdu.payload, pdu.payload_len);
+        len = (payload_len < 0) ? -1 : len + payload_len;
+    }
+    if (len < 0) {
+        coap_hdr_set_code(pdu.hdr, COAP_CODE_INTERNAL_SERVER_ERROR);
+        len = hdr_len;
+    }
+
+    /* a response is sent like a request, there is no reply to handle */
+    if (gcoap_req_send(buf, len, &job->remote, NULL, NULL) <= 0) {
+        DEBUG("gcoap: unable to send separate response\n");
+    }
+}
+
+static void _respond_pack(const saul_job_t *job);
+
+static void *_worker(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        msg_t msg;
+        mbox_get(&_queue, &msg);
+
+        saul_job_t *job = msg.content.ptr;
+        if (job->saul_dev) {
+            _respond(job);
+        }
+        else {
+            _respond_pack(job);
+        }
+        _job_free(job);
+    }
+
+    return NULL;
+}
+
+/* values for one device collected from a write request, dimension i is
+ * val[i] * 10^exp[i] */
+typedef struct {
+    saul_dev_t *saul_dev;               /* device to write */
+    int32_t val[PHYDAT_DIM];
+    int32_t exp[PHYDAT_DIM];
+    uint8_t unit;                       /* UNIT_UNDEF unless given */
+    uint8_t dim;                        /* highest dimension set + 1 */
+    phydat_t data;                      /* what is written in the end */
+} saul_write_req_t;
+
+/* the devices written by one request */
+typedef struct {
+    saul_write_req_t *reqs;
+    unsigned numof;                     /* entries of reqs in use */
+    unsigned max;                       /* 1 if the device is given by the URI */
+} saul_write_batch_t;
+
+/* devices written by one PUT on /saul, only used by the gcoap thread */
+static saul_write_req_t _write_reqs[SAUL_DEVICE_COUNT];
+
+static int _write_set(saul_write_req_t *req, unsigned idx, int32_t m, int32_t e)
+{
+    if ((idx >= PHYDAT_DIM) || (e < SAUL_WRITE_EXP_MIN) || (e > SAUL_WRITE_EXP_MAX)) {
+        return -EINVAL;
+    }
+
+    req->val[idx] = m;
+    req->exp[idx] = e;
+    if (idx >= req->dim) {
+        req->dim = idx + 1;
+    }
+
+    return 0;
+}
+
+/* "<v0>[ <v1>[ <v2>]][ e<scale>]", for example "255 0 128" or "215 e-1" */
+static int _parse_text(const uint8_t *payload, size_t payload_len, saul_write_req_t *req)
+{
+    char text[CONFIG_SAUL_WRITE_TEXT_MAX];
+    long scale = 0;
+    char *pos = text;
+    char *end;
+
+    if (payload_len >= sizeof(text)) {
+        return -EMSGSIZE;
+    }
+    memcpy(text, payload, payload_len);
+    text[payload_len] = '\0';
+
+    while (1) {
+        while (isspace((unsigned char)*pos)) {
+            pos++;
+        }
+        if (*pos == '\0') {
+            break;
+        }
+        if (*pos == 'e') {
+            scale = strtol(pos + 1, &end, 10);
+            if ((end == pos + 1) || (*end != '\0')) {
+                return -EINVAL;
+            }
+            break;
+        }
+
+        long val = strtol(pos, &end, 10);
+        if ((end == pos) || (val < INT32_MIN) || (val > INT32_MAX)
+            || (_write_set(req, req->dim, val, 0) < 0)) {
+            return -EINVAL;
+        }
+        pos = end;
+    }
+
+    if (req->dim == 0) {
+        return -EINVAL;
+    }
+    for (unsigned i = 0; i < req->dim; i++) {
+        if (_write_set(req, i, req->val[i], scale) < 0) {
+            return -EINVAL;
+        }
+    }
+
+    return 0;
+}
+
+/* character @p i of the name of @p rec, which is its base name and name */
+static char _name_at(const saul_senml_record_t *rec, size_t i)
+{
+    return (i < rec->bn_len) ? rec->bn[i] : rec->n[i - rec->bn_len];
+}
+
+static saul_write_req_t *_batch_req(saul_write_batch_t *batch,
+                                    const saul_senml_record_t *rec, size_t name_len)
+{
+    saul_dev_t *saul_dev = NULL;
+
+    for (unsigned i = 0; (i < _devs_numof) && (saul_dev == NULL); i++) {
+        const char *name = _devs[i].reg->name;
+        size_t j = 0;
+        while ((j < name_len) && (name[j] == _name_at(rec, j))) {
+            j++;
+        }
+        if ((j == name_len) && (name[j] == '\0')) {
+            saul_dev = &_devs[i];
+        }
+    }
+    if (saul_dev == NULL) {
+        return NULL;
+    }
+
+    for (unsigned i = 0; i < batch->numof; i++) {
+        if (batch->reqs[i].saul_dev == saul_dev) {
+            return &batch->reqs[i];
+        }
+    }
+    if (batch->numof == batch->max) {
+        return NULL;
+    }
+
+    saul_write_req_t *req = &batch->reqs[batch->numof++];
+    *req = (saul_write_req_t){ .saul_dev = saul_dev };
+    return req;
+}
+
+/* records named "<device>" or "<device>/<dimension>", the device is taken from
+ * the URI instead when writing a single one */
+static int _on_record(const saul_senml_record_t *rec, void *arg)
+{
+    saul_write_batch_t *batch = arg;
+    size_t name_len = rec->bn_len + rec->n_len;
+    int idx = -1;
+
+    if ((name_len >= 2) && (_name_at(rec, name_len - 2) == '/')
+        && isdigit((unsigned char)_name_at(rec, name_len - 1))) {
+        idx = _name_at(rec, name_len - 1) - '0';
+        name_len -= 2;
+    }
+
+    saul_write_req_t *req = (batch->max == 1) ? &batch->reqs[0]
+                                              : _batch_req(batch, rec, name_len);
+    if (req == NULL) {
+        return -ENOENT;
+    }
+    if (rec->u_len) {
+        req->unit = saul_senml_unit_from_str(rec->u, rec->u_len);
+    }
+
+    return _write_set(req, (idx < 0) ? req->dim : (unsigned)idx, rec->m, rec->e);
+}
+
+static int _parse_write(coap_pkt_t *pdu, saul_write_batch_t *batch)
+{
+    switch (coap_get_content_type(pdu)) {
+    case COAP_FORMAT_NONE:
+    case COAP_FORMAT_TEXT:
+        if (batch->max != 1) {
+            return -EPROTONOSUPPORT;
+        }
+        return _parse_text(pdu->payload, pdu->payload_len, &batch->reqs[0]);
+    case COAP_FORMAT_SENML_CBOR:
+        return saul_senml_cbor_parse(pdu->payload, pdu->payload_len, _on_record, batch);
+    default:
+        return -EPROTONOSUPPORT;
+    }
+}
+
+/* brings the values to a common scale that fits into a phydat_t */
+static int _to_phydat(saul_write_req_t *req)
+{
+    int32_t vals[PHYDAT_DIM] = { 0 };
+    int32_t scale = SAUL_WRITE_EXP_MAX;
+
+    if (req->dim == 0) {
+        return -EINVAL;
+    }
+    for (unsigned i = 0; i < req->dim; i++) {
+        if ((req->val[i] != 0) && (req->exp[i] < scale)) {
+            scale = req->exp[i];
+        }
+    }
+    if (scale == SAUL_WRITE_EXP_MAX) {
+        /* all zero */
+        scale = 0;
+    }
+
+    for (unsigned i = 0; i < req->dim; i++) {
+        int32_t val = req->val[i];
+        for (int32_t e = scale; (val != 0) && (e < req->exp[i]); e++) {
+            if ((val > INT32_MAX / 10) || (val < INT32_MIN / 10)) {
+                return -ERANGE;
+            }
+            val *= 10;
+        }
+        vals[i] = val;
+    }
+
+    memset(&req->data, 0, sizeof(req->data));
+    req->data.unit = req->unit;
+    req->data.scale = scale;
+    phydat_fit(&req->data, vals, req->dim);
+
+    return 0;
+}
+
+static int _write(saul_write_req_t *req)
+{
+    int res = saul_reg_write(req->saul_dev->reg, &req->data);
+
+    _invalidate(req->saul_dev);
+
+    return res;
+}
+
+static unsigned _write_code(int res)
+{
+    switch (res) {
+    case -EMSGSIZE:
+        return COAP_CODE_REQUEST_ENTITY_TOO_LARGE;
+    case -EPROTONOSUPPORT:
+        return COAP_CODE_UNSUPPORTED_CONTENT_FORMAT;
+    case -ENOENT:
+        return COAP_CODE_NOT_FOUND;
+    case -ENOTSUP:
+        return COAP_CODE_METHOD_NOT_ALLOWED;
+    case -EBADMSG:
+    case -EINVAL:
+    case -ERANGE:
+        return COAP_CODE_BAD_REQUEST;
+    default:
+        return (res < 0) ? COAP_CODE_INTERNAL_SERVER_ERROR : COAP_CODE_CHANGED;
+    }
+}
+
 static ssize_t _saul_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len, coap_request_ctx_t *ctx)
 {
-    (void)ctx;
-    /* write the RIOT board name in the response buffer */
-    saul_reg_t *dev = saul_reg_find_name(ctx->resource->path + 1);
+    /* resolved once in server_init() */
+    saul_dev_t *saul_dev = coap_request_ctx_get_context(ctx);
+    saul_reg_t *dev = saul_dev->reg;
 
-    int buf_pos = 0;
-    
     /* read coap method type in packet */
     unsigned method_flag = coap_method2flag(coap_get_code_detail(pdu));
     switch (method_flag) {
         case COAP_GET: {
+            unsigned format = coap_get_accept(pdu);
+            if (format == COAP_FORMAT_NONE) {
+                format = COAP_FORMAT_TEXT;
+            }
+            if ((format != COAP_FORMAT_TEXT) && (format != COAP_FORMAT_SENML_CBOR)
+                && (format != COAP_FORMAT_SENML_JSON)) {
+                return gcoap_response(pdu, buf, len, COAP_CODE_NOT_ACCEPTABLE);
+            }
+
+            phydat_t res;
+            uint32_t ttl_left_ms;
+            int dim;
+            /* registrations need the response from gcoap's thread */
+            if (saul_dev->slow && !coap_has_observe(pdu)) {
+                dim = _read_cached(saul_dev, &res, &ttl_left_ms);
+                if (dim <= 0) {
+                    saul_job_t req = { .saul_dev = saul_dev, .format = format };
+                    return _defer(pdu, buf, len, ctx, &req);
+                }
+            }
+            else {
+                dim = _read(saul_dev, &res, &ttl_left_ms);
+            }
+            if (dim <= 0) {
+                return gcoap_response(pdu, buf, len, COAP_CODE_INTERNAL_SERVER_ERROR);
+            }
+
+            /* notifications use the format of the registration */
+            if (coap_has_observe(pdu) && (coap_get_observe(pdu) == COAP_OBS_REGISTER)) {
+                saul_dev->obs_format = format;
+            }
+
             gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
-            coap_opt_add_format(pdu, COAP_FORMAT_TEXT);
+            coap_opt_add_format(pdu, format);
+            /* without Max-Age clients would assume 60 s */
+            coap_opt_add_uint(pdu, COAP_OPT_MAX_AGE, ttl_left_ms / 1000U);
             size_t resp_len = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
-            phydat_t res;
-            int dim = saul_reg_read(dev, &res);
-            buf_pos = phydat_to_str(&res, dim, (char*)pdu->payload, pdu->payload_len);
-            return resp_len + buf_pos;
+            ssize_t payload_len = _format_reading(format, dev, &res, dim,
+                                                  pdu->payload, pdu->payload_len);
+            if (payload_len < 0) {
+                return gcoap_response(pdu, buf, len, COAP_CODE_INTERNAL_SERVER_ERROR);
+            }
+            return resp_len + payload_len;
         }
         case COAP_PUT: {
-            phydat_t data;
-            char payload[6] = { 0 };
-            memcpy(payload, (char *)pdu->payload, pdu->payload_len);
-            data.val[0] = atoi(payload);
-            saul_reg_write(dev, &data);
-            return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
+            saul_write_req_t req = { .saul_dev = saul_dev };
+            saul_write_batch_t batch = { .reqs = &req, .numof = 1, .max = 1 };
+            int res = _parse_write(pdu, &batch);
+            if (res == 0) {
+                res = _to_phydat(&req);
+            }
+            if (res == 0) {
+                res = _write(&req);
+            }
+            return gcoap_response(pdu, buf, len, _write_code(res));
         }
     }
     
     return 0;
 }
 
+static bool _changed(const saul_dev_t *saul_dev, const phydat_t *data, int dim)
+{
+    if ((dim != saul_dev->notified_dim) || (data->unit != saul_dev->notified.unit)
+        || (data->scale != saul_dev->notified.scale)) {
+        return true;
+    }
+    for (int i = 0; i < dim; i++) {
+        if (abs(data->val[i] - saul_dev->notified.val[i]) >= CONFIG_SAUL_OBS_DELTA) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* reads each observed device once and notifies its observer of changes */
+static void _on_sample(event_t *ev)
+{
+    (void)ev;
+    uint32_t now = ztimer_now(ZTIMER_MSEC);
+
+    for (unsigned i = 0; i < _devs_numof; i++) {
+        saul_dev_t *saul_dev = &_devs[i];
+        coap_pkt_t pdu;
+
+        /* devices nobody observes are not read at all */
+        if (gcoap_obs_init(&pdu, _obs_buf, sizeof(_obs_buf),
+                           saul_dev->resource) != GCOAP_OBS_INIT_OK) {
+            continue;
+        }
+
+        phydat_t data;
+        int dim = _read(saul_dev, &data, NULL);
+        if (dim <= 0) {
+            continue;
+        }
+
+        bool heartbeat = (now - saul_dev->notified_at) >= CONFIG_SAUL_OBS_MAX_AGE_S * 1000U;
+        if (!heartbeat && !_changed(saul_dev, &data, dim)) {
+            continue;
+        }
+
+        /* heartbeats are confirmable, so the observer has to show it is
+         * still there */
+        if (heartbeat) {
+            coap_hdr_set_type(pdu.hdr, COAP_TYPE_CON);
+        }
+        coap_opt_add_format(&pdu, saul_dev->obs_format);
+        coap_opt_add_uint(&pdu, COAP_OPT_MAX_AGE, SAUL_OBS_MAX_AGE);
+        size_t len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+        ssize_t payload_len = _format_reading(saul_dev->obs_format, saul_dev->reg,
+                                              &data, dim, pdu.payload, pdu.payload_len);
+        if (payload_len < 0) {
+            continue;
+        }
+
+        if (gcoap_obs_send(_obs_buf, len + payload_len, saul_dev->resource) > 0) {
+            saul_dev->notified = data;
+            saul_dev->notified_dim = dim;
+            saul_dev->notified_at = now;
+        }
+    }
+}
+
+/* reads all devices whose class starts with @p class into _pack, with
+ * @p cached_only slow devices are only taken from their cache and
+ * -EWOULDBLOCK is returned if one of them is stale */
+static ssize_t _read_all(unsigned format, const char *class, size_t class_len,
+                         bool cached_only)
+{
+    saul_senml_cbor_t cbor;
+    saul_senml_json_t json;
+
+    if (format == COAP_FORMAT_SENML_CBOR) {
+        saul_senml_cbor_init(&cbor, _pack, sizeof(_pack));
+    }
+    else {
+        saul_senml_json_init(&json, (char *)_pack, sizeof(_pack));
+    }
+
+    for (size_t i = 0; i < _links.listener.resources_len; i++) {
+        saul_dev_t *saul_dev = _resources[i].context;
+        if (saul_dev == NULL) {
+            /* not a device */
+            continue;
+        }
+        saul_reg_t *dev = saul_dev->reg;
+        if (class) {
+            const char *dev_class = saul_class_to_str(dev->driver->type);
+            if ((dev_class == NULL) || (strncmp(dev_class, class, class_len) != 0)) {
+                continue;
+            }
+        }
+
+        phydat_t data;
+        int dim;
+        if (cached_only && saul_dev->slow) {
+            uint32_t ttl_left_ms;
+            dim = _read_cached(saul_dev, &data, &ttl_left_ms);
+            if (dim <= 0) {
+                return -EWOULDBLOCK;
+            }
+        }
+        else {
+            dim = _read(saul_dev, &data, NULL);
+        }
+        if (dim <= 0) {
+            continue;
+        }
+        if (format == COAP_FORMAT_SENML_CBOR) {
+            saul_senml_cbor_add(&cbor, dev->name, &data, dim);
+        }
+        else {
+            saul_senml_json_add(&json, dev->name, &data, dim);
+        }
+    }
+
+    return (format == COAP_FORMAT_SENML_CBOR) ? saul_senml_cbor_finish(&cbor)
+                                              : saul_senml_json_finish(&json);
+}
+
+/* PUT /saul, a SenML+CBOR pack for several devices, nothing is written
+ * unless all of it is valid */
+static ssize_t _saul_batch_write(coap_pkt_t *pdu, uint8_t *buf, size_t len)
+{
+    saul_write_batch_t batch = { .reqs = _write_reqs, .max = ARRAY_SIZE(_write_reqs) };
+    int res = _parse_write(pdu, &batch);
+
+    for (unsigned i = 0; (res == 0) && (i < batch.numof); i++) {
+        res = _to_phydat(&batch.reqs[i]);
+    }
+    if (res < 0) {
+        return gcoap_response(pdu, buf, len, _write_code(res));
+    }
+
+    /* the first failure is reported, the other devices are written anyway */
+    for (unsigned i = 0; i < batch.numof; i++) {
+        int write_res = _write(&batch.reqs[i]);
+        if ((write_res < 0) && (res == 0)) {
+            res = write_res;
+        }
+    }
+
+    return gcoap_response(pdu, buf, len, _write_code(res));
+}
+
+/* takes a new snapshot into _pack, _pack_lock must be held */
+static ssize_t _pack_snapshot(unsigned format, const char *class, size_t class_len,
+                              bool cached_only)
+{
+    ssize_t pack_len = _read_all(format, class, class_len, cached_only);
+    if (pack_len < 0) {
+        if (pack_len == -ENOBUFS) {
+            puts("gcoap: SenML pack exceeds CONFIG_SAUL_PACK_SIZE");
+        }
+        _pack_format = COAP_FORMAT_NONE;
+        return pack_len;
+    }
+
+    _pack_len = pack_len;
+    _pack_format = format;
+    _pack_class_len = class_len;
+    if (class_len) {
+        memcpy(_pack_class, class, class_len);
+    }
+    _pack_etag++;
+
+    return pack_len;
+}
+
+/* adds the block of the snapshot selected by @p slicer to a response whose
+ * header is set up, _pack_lock must be held */
+static size_t _put_pack(coap_pkt_t *pdu, coap_block_slicer_t *slicer)
+{
+    coap_opt_add_opaque(pdu, COAP_OPT_ETAG, (uint8_t *)&_pack_etag, sizeof(_pack_etag));
+    coap_opt_add_format(pdu, _pack_format);
+    coap_opt_add_block2(pdu, slicer, 1);
+    size_t len = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+
+    len += coap_blockwise_put_bytes(slicer, pdu->payload, _pack, _pack_len);
+    coap_block2_finish(slicer);
+
+    return len;
+}
+
+/* takes the snapshot of a deferred GET /saul, reading the stale slow
+ * devices, and sends its first block as separate response */
+static void _respond_pack(const saul_job_t *job)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    coap_block_slicer_t slicer;
+
+    ssize_t hdr_len = coap_build_hdr((coap_hdr_t *)buf, job->type, job->token,
+                                     job->token_len, COAP_CODE_CONTENT,
+                                     atomic_fetch_add(&_msg_id, 1));
+    coap_pkt_init(&pdu, buf, sizeof(buf), hdr_len);
+
+    mutex_lock(&_pack_lock);
+    ssize_t len = _pack_snapshot(job->format, job->class, job->class_len, false);
+    if (len >= 0) {
+        coap_block_slicer_init(&slicer, 0, job->blksize);
+        len = _put_pack(&pdu, &slicer);
+    }
+    mutex_unlock(&_pack_lock);
+
+    if (len < 0) {
+        coap_hdr_set_code(pdu.hdr, COAP_CODE_INTERNAL_SERVER_ERROR);
+        len = hdr_len;
+    }
+
+    if (gcoap_req_send(buf, len, &job->remote, NULL, NULL) <= 0) {
+        DEBUG("gcoap: unable to send separate response\n");
+    }
+}
+
+/* GET /saul[?class=<SAUL class prefix>], all devices in one SenML pack. Only
+ * cached readings of slow devices are used on the gcoap thread, if one is
+ * stale the whole snapshot is deferred to a worker. */
+static ssize_t _saul_batch_read(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                                coap_request_ctx_t *ctx)
+{
+    unsigned format = coap_get_accept(pdu);
+    if (format == COAP_FORMAT_NONE) {
+        format = COAP_FORMAT_SENML_CBOR;
+    }
+    if ((format != COAP_FORMAT_SENML_CBOR) && (format != COAP_FORMAT_SENML_JSON)) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_NOT_ACCEPTABLE);
+    }
+
+    const char *class = NULL;
+    size_t class_len = 0;
+    if (!coap_find_uri_query(pdu, "class", &class, &class_len)) {
+        class = NULL;
+    }
+    if (class_len > sizeof(_pack_class)) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+    }
+
+    /* a worker is taking a snapshot */
+    if (!mutex_trylock(&_pack_lock)) {
+        return _unavailable(pdu, buf, len);
+    }
+
+    coap_block_slicer_t slicer;
+    coap_block2_init(pdu, &slicer);
+
+    /* a snapshot of another format or filter cannot be continued, the
+     * transfer starts over with the new one */
+    bool same = (format == _pack_format) && (class_len == _pack_class_len)
+                && ((class_len == 0) || (memcmp(class, _pack_class, class_len) == 0));
+    if (!same) {
+        coap_block_slicer_init(&slicer, 0, slicer.end - slicer.start);
+    }
+
+    ssize_t res = 0;
+    if (slicer.start == 0) {
+        res = _pack_snapshot(format, class, class_len, true);
+    }
+    if (res < 0) {
+        mutex_unlock(&_pack_lock);
+        if (res != -EWOULDBLOCK) {
+            return gcoap_response(pdu, buf, len, COAP_CODE_INTERNAL_SERVER_ERROR);
+        }
+
+        saul_job_t req = {
+            .format = format,
+            .class_len = class_len,
+            .blksize = slicer.end - slicer.start,
+        };
+        if (class_len) {
+            memcpy(req.class, class, class_len);
+        }
+        return _defer(pdu, buf, len, ctx, &req);
+    }
+
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    size_t resp_len = _put_pack(pdu, &slicer);
+
+    mutex_unlock(&_pack_lock);
+
+    return resp_len;
+}
+
+static ssize_t _saul_batch_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                                   coap_request_ctx_t *ctx)
+{
+    if (coap_method2flag(coap_get_code_detail(pdu)) == COAP_PUT) {
+        return _saul_batch_write(pdu, buf, len);
+    }
+
+    return _saul_batch_read(pdu, buf, len, ctx);
+}
+
+/* writes the link parameters of a device to @p buf, like
+ * ;rt="saul.sense.temp";if="core.s";obs
+ * returns the bytes used including the terminator. The unit is left out, only
+ * a read tells it and reading every device here would hold up the boot, each
+ * reading carries it anyway. */
+static int _format_link_params(saul_dev_t *saul_dev, char *buf, size_t size)
+{
+    static const char rt[] = ";rt=\"saul.";
+    uint8_t type = saul_dev->reg->driver->type;
+    const char *class = saul_class_to_str(type);
+
+    int len = snprintf(buf, size, "%s%s\";if=\"%s\";obs", rt,
+                       (class == NULL) ? "undef" : class,
+                       ((type & SAUL_CAT_MASK) == SAUL_CAT_ACT) ? "core.a" : "core.s");
+    if ((len < 0) || ((size_t)len >= size)) {
+        return -ENOBUFS;
+    }
+
+    /* "SENSE_TEMP" becomes "saul.sense.temp", RD lookups match it exactly */
+    for (char *c = &buf[sizeof(rt) - 1]; *c != '"'; c++) {
+        *c = (*c == '_') ? '.' : tolower((unsigned char)*c);
+    }
+
+    return len + 1;
+}
+
 void server_init(void)
 {
     
@@ -250,18 +1228,38 @@ saul_reg_write(dev, &data);
 #endif
 
     int i = 0;
+    size_t uris_pos = 0;
     for (saul_reg_t *dev = saul_reg; dev != NULL; dev = dev->next) {
         // Create the device type string
         // const char *dev_type = saul_class_to_str(dev->driver->type);
 
-        // Create the resource_uri string
-        int resource_uri_len = snprintf(NULL, 0, "/%s", dev->name) + 1;
-        char *resource_uri = malloc(sizeof(char)*resource_uri_len);
-        snprintf(resource_uri, resource_uri_len, "/%s", dev->name);
+        if (i == SAUL_DEVICE_COUNT) {
+            puts("gcoap: more SAUL devices than SAUL_DEVICE_COUNT");
+            break;
+        }
 
-        // Init array items inside resources and link_params arrays
-        _resources[i] = (coap_resource_t){ resource_uri, COAP_GET | COAP_PUT, _saul_handler, NULL };
-        _link_params[i] = NULL;
+        // Create the resource_uri string in the arena
+        char *resource_uri = &_uris[uris_pos];
+        int resource_uri_len = (dev->name == NULL) ? 0
+                               : snprintf(resource_uri, sizeof(_uris) - uris_pos,
+                                          "/%s", dev->name) + 1;
+        if ((resource_uri_len == 0) || ((size_t)resource_uri_len > sizeof(_uris) - uris_pos)) {
+            printf("gcoap: no URI for SAUL device #%d\n", i);
+            continue;
+        }
+        uris_pos += resource_uri_len;
+
+        // Init array items inside the resources array, the
+        // device is the context so requests need no registry lookup
+        _devs[_devs_numof] = (saul_dev_t){
+            .reg = dev,
+            .slow = _class_slow(dev->driver->type),
+            .lock = MUTEX_INIT,
+            .ttl_ms = _class_ttl(dev->driver->type),
+            .obs_format = COAP_FORMAT_TEXT,
+        };
+        _resources[i] = (coap_resource_t){ resource_uri, COAP_GET | COAP_PUT, _saul_handler,
+                                           &_devs[_devs_numof++] };
 
         // Increase dev counter
         i++;
@@ -269,14 +1267,54 @@ saul_reg_write(dev, &data);
 
     // coap get [fe80::e8e4:4534:4649:f34b]:5683 /.well-known/core
 
-    _listener = (gcoap_listener_t) {
-        &_resources[0],
-        i,
-        GCOAP_SOCKET_TYPE_UNDEF,
-        _encode_link,
-        NULL,
-        NULL
-    };
+    // Read all devices at once
+    _resources[i] = (coap_resource_t){ "/saul", COAP_GET | COAP_PUT, _saul_batch_handler, NULL };
+    i++;
+
+    /* the registry is in the order the devices were found */
+    coap_links_sort(_resources, i);
+
+    // Link parameters follow the sorted table, the RD gets them from the
+    // cached link format just like /.well-known/core
+    size_t params_pos = 0;
+    for (int j = 0; j < i; j++) {
+        saul_dev_t *saul_dev = _resources[j].context;
+        if (saul_dev == NULL) {
+            _link_params[j] = ";rt=\"saul.batch\";ct=\"110 112\"";
+            continue;
+        }
+        int len = _format_link_params(saul_dev, &_link_params_buf[params_pos],
+                                      sizeof(_link_params_buf) - params_pos);
+        if (len < 0) {
+            printf("gcoap: no link parameters for %s\n", _resources[j].path);
+            _link_params[j] = NULL;
+            continue;
+        }
+        _link_params[j] = &_link_params_buf[params_pos];
+        params_pos += len;
+    }
+    if (coap_links_init(&_links, _resources, i, _link_params) < 0) {
+        return;
+    }
+
+    gcoap_register_listener(&_links.listener);
+
+    /* the resources are in place now, notifications can refer to them */
+    for (int j = 0; j < i; j++) {
+        saul_dev_t *saul_dev = _resources[j].context;
+        if (saul_dev) {
+            saul_dev->resource = &_resources[j];
+        }
+    }
+    mbox_init(&_queue, _queue_msgs, ARRAY_SIZE(_queue_msgs));
+    atomic_store(&_msg_id, random_uint32());
+    /* ETags of a previous boot are not mistaken for current ones */
+    _pack_etag = random_uint32();
+    for (unsigned j = 0; j < CONFIG_SAUL_WORKERS; j++) {
+        thread_create(_worker_stacks[j], sizeof(_worker_stacks[j]), THREAD_PRIORITY_MAIN,
+                      THREAD_CREATE_STACKTEST, _worker, NULL, "saul_worker");
+    }
 
-    gcoap_register_listener(&_listener);
+    event_periodic_init(&_sampler, ZTIMER_MSEC, EVENT_PRIO_MEDIUM, &_ev_sample);
+    event_periodic_start(&_sampler, CONFIG_SAUL_OBS_PERIOD_MS);
 }